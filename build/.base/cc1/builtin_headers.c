@@ -0,0 +1,71 @@
+// Generated from include/*.h by src/cc1/gen_builtin_headers.awk. Do not edit.
+
+const char* builtin_header_contents[] = {
+    "#ifndef __DUCC_BUILTIN___ASSERT_H__\n"
+    "#define __DUCC_BUILTIN___ASSERT_H__\n"
+    "\n"
+    "#ifdef NDEBUG\n"
+    "#define assert(x) ((void)0)\n"
+    "#else\n"
+    "#define assert(x) \\\n"
+    "    do { \\\n"
+    "        if (!(x)) { \\\n"
+    "            fprintf(stderr, \"%s:%d: assertion failed.\\n\", __FILE__, __LINE__); \\\n"
+    "            abort(); \\\n"
+    "        } \\\n"
+    "    } while (0)\n"
+    "#endif\n"
+    "\n"
+    "#endif\n"
+,
+    "#ifndef __DUCC_BUILTIN___STDARG_H__\n"
+    "#define __DUCC_BUILTIN___STDARG_H__\n"
+    "\n"
+    "// System V Application Binary Interface\n"
+    "// AMD64 Architecture Processor Supplement\n"
+    "// (With LP64 and ILP32 Programming Models)\n"
+    "// Version 1.0\n"
+    "// Figure 3.34: va_list Type Declaration\n"
+    "struct __ducc_va_list {\n"
+    "    unsigned int gp_offset;\n"
+    "    unsigned int fp_offset;\n"
+    "    void* overflow_arg_area;\n"
+    "    void* reg_save_area;\n"
+    "};\n"
+    "typedef struct __ducc_va_list va_list[1];\n"
+    "\n"
+    "#define va_start(args, start) __ducc_va_start(args, start)\n"
+    "#define va_end(args)\n"
+    "#define va_arg(args, T) (*(T*)__ducc_va_arg(args, sizeof(T)))\n"
+    "\n"
+    "// For glibc:\n"
+    "typedef va_list __gnuc_va_list;\n"
+    "\n"
+    "#endif\n"
+,
+    "#ifndef __DUCC_BUILTIN___STDDEF_H__\n"
+    "#define __DUCC_BUILTIN___STDDEF_H__\n"
+    "\n"
+    "#define NULL 0\n"
+    "\n"
+    "typedef unsigned long size_t;\n"
+    "typedef int wchar_t;\n"
+    "typedef long ptrdiff_t;\n"
+    "\n"
+    "#define offsetof(T, m) ((ptrdiff_t)(void*)(&((T*)0)->m))\n"
+    "\n"
+    "// TODO:\n"
+    "// - max_align_t (C11)\n"
+    "// - nullptr_t (C23)\n"
+    "\n"
+    "#endif\n"
+,
+    0,
+};
+
+const char* builtin_header_names[] = {
+    "assert.h",
+    "stdarg.h",
+    "stddef.h",
+    0,
+};
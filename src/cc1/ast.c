@@ -1,4 +1,5 @@
 #include "ast.h"
+#include "../lib/arena.h"
 #include "../lib/common.h"
 #include "preprocess.h"
 
@@ -82,29 +83,110 @@ static AstNode* members_of(Type* ty) {
         return def->as.union_def->members;
 }
 
-Type* type_new(TypeKind kind) {
-    Type* ty = calloc(1, sizeof(Type));
+static Type* type_alloc(TypeKind kind) {
+    Type* ty = arena_alloc(&parse_arena, sizeof(Type));
     ty->kind = kind;
     return ty;
 }
 
-Type* type_dup(Type* src) {
-    Type* ty = malloc(sizeof(Type));
-    memcpy(ty, src, sizeof(Type));
-    return ty;
+// The canonical types of the basic kinds, created on first use.
+static Type* basic_types[TypeKind_func + 1];
+
+// The canonical pointer, array, struct, union and enum types, keyed by their kind, base, array size and definition. An
+// open-addressing hash table with linear probing; NULL marks an empty slot.
+typedef struct {
+    size_t len;
+    size_t capacity;
+    // log2(capacity)
+    int bits;
+    Type** data;
+} TypeContext;
+
+static TypeContext types;
+
+static void types_init(int bits) {
+    types.len = 0;
+    types.bits = bits;
+    types.capacity = (size_t)1 << bits;
+    types.data = calloc(types.capacity, sizeof(Type*));
+}
+
+// Returns the slot of the type made of the given parts, or the empty slot where it would go.
+static size_t types_slot(TypeKind kind, Type* base, int array_size, AstNode* defs, size_t index) {
+    // Types and definitions are at least 16-byte aligned, so the low bits of their addresses carry nothing.
+    size_t h = kind;
+    h = h * 31 + (size_t)base / 16;
+    h = h * 31 + array_size;
+    h = h * 31 + (size_t)defs / 16;
+    h = h * 31 + index;
+    size_t mask = types.capacity - 1;
+    size_t slot = hash_mix(h, types.bits);
+    while (types.data[slot]) {
+        Type* ty = types.data[slot];
+        if (ty->kind == kind && ty->base == base && ty->array_size == array_size && ty->ref.defs == defs &&
+            ty->ref.index == index) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
 }
 
-Type* type_new_ptr(Type* base) {
-    Type* ty = type_new(TypeKind_ptr);
+static Type* types_intern(TypeKind kind, Type* base, int array_size, AstNode* defs, size_t index) {
+    if (!types.data) {
+        types_init(8);
+    }
+    size_t slot = types_slot(kind, base, array_size, defs, index);
+    if (types.data[slot]) {
+        return types.data[slot];
+    }
+
+    // Keep the table at most half full.
+    if ((types.len + 1) * 2 > types.capacity) {
+        Type** old_data = types.data;
+        size_t old_capacity = types.capacity;
+        types_init(types.bits + 1);
+        for (size_t i = 0; i < old_capacity; ++i) {
+            Type* ty = old_data[i];
+            if (ty) {
+                types.data[types_slot(ty->kind, ty->base, ty->array_size, ty->ref.defs, ty->ref.index)] = ty;
+                ++types.len;
+            }
+        }
+        free(old_data);
+        slot = types_slot(kind, base, array_size, defs, index);
+    }
+    Type* ty = type_alloc(kind);
     ty->base = base;
+    ty->array_size = array_size;
+    ty->ref.defs = defs;
+    ty->ref.index = index;
+    types.data[slot] = ty;
+    ++types.len;
     return ty;
 }
 
+Type* type_new(TypeKind kind) {
+    if (kind == TypeKind_struct || kind == TypeKind_union || kind == TypeKind_enum || kind == TypeKind_ptr ||
+        kind == TypeKind_array || kind == TypeKind_func) {
+        fatal_error("type_new: %s is not a basic type", type_kind_stringify(kind));
+    }
+    if (!basic_types[kind]) {
+        basic_types[kind] = type_alloc(kind);
+    }
+    return basic_types[kind];
+}
+
+Type* type_new_ref(TypeKind kind, AstNode* defs, size_t index) {
+    return types_intern(kind, NULL, 0, defs, index);
+}
+
+Type* type_new_ptr(Type* base) {
+    return types_intern(TypeKind_ptr, base, 0, NULL, 0);
+}
+
 Type* type_new_array(Type* base, int size) {
-    Type* ty = type_new(TypeKind_array);
-    ty->base = base;
-    ty->array_size = size;
-    return ty;
+    return types_intern(TypeKind_array, base, size, NULL, 0);
 }
 
 Type* type_new_static_string(int len) {
@@ -116,7 +198,7 @@ Type* type_array_to_ptr(Type* ty) {
 }
 
 Type* type_new_func(Type* result, AstNode* params) {
-    Type* ty = type_new(TypeKind_func);
+    Type* ty = type_alloc(TypeKind_func);
     ty->result = result;
     ty->params = params;
     return ty;
@@ -225,6 +307,8 @@ const char* astnode_kind_stringify(AstNodeKind k) {
         return "deref_expr";
     case AstNodeKind_do_while_stmt:
         return "do_while_stmt";
+    case AstNodeKind_embedded_data:
+        return "embedded_data";
     case AstNodeKind_enum_def:
         return "enum_def";
     case AstNodeKind_enum_member:
@@ -297,7 +381,7 @@ const char* astnode_kind_stringify(AstNodeKind k) {
 }
 
 AstNode* ast_new(AstNodeKind kind) {
-    AstNode* ast = calloc(1, sizeof(AstNode));
+    AstNode* ast = arena_alloc(&parse_arena, sizeof(AstNode));
     ast->kind = kind;
     return ast;
 }
@@ -306,7 +390,7 @@ AstNode* ast_new_list(int capacity) {
     if (capacity == 0)
         unreachable();
     AstNode* list = ast_new(AstNodeKind_list);
-    list->as.list = calloc(1, sizeof(ListNode));
+    list->as.list = arena_alloc(&parse_arena, sizeof(ListNode));
     list->as.list->cap = capacity;
     list->as.list->len = 0;
     list->as.list->items = calloc(list->as.list->cap, sizeof(AstNode));
@@ -332,7 +416,7 @@ void ast_append(AstNode* list, AstNode* item) {
 
 AstNode* ast_new_int(int v) {
     AstNode* e = ast_new(AstNodeKind_int_expr);
-    e->as.int_expr = calloc(1, sizeof(IntExprNode));
+    e->as.int_expr = arena_alloc(&parse_arena, sizeof(IntExprNode));
     e->as.int_expr->value = v;
     e->ty = type_new(TypeKind_int);
     return e;
@@ -340,7 +424,7 @@ AstNode* ast_new_int(int v) {
 
 AstNode* ast_new_double(double v) {
     AstNode* e = ast_new(AstNodeKind_double_expr);
-    e->as.double_expr = calloc(1, sizeof(DoubleExprNode));
+    e->as.double_expr = arena_alloc(&parse_arena, sizeof(DoubleExprNode));
     e->as.double_expr->value = v;
     e->ty = type_new(TypeKind_double);
     return e;
@@ -348,7 +432,7 @@ AstNode* ast_new_double(double v) {
 
 AstNode* ast_new_unary_expr(int op, AstNode* operand) {
     AstNode* e = ast_new(AstNodeKind_unary_expr);
-    e->as.unary_expr = calloc(1, sizeof(UnaryExprNode));
+    e->as.unary_expr = arena_alloc(&parse_arena, sizeof(UnaryExprNode));
     e->as.unary_expr->op = op;
     e->as.unary_expr->operand = operand;
     e->ty = type_new(TypeKind_int);
@@ -357,7 +441,7 @@ AstNode* ast_new_unary_expr(int op, AstNode* operand) {
 
 AstNode* ast_new_binary_expr(int op, AstNode* lhs, AstNode* rhs) {
     AstNode* e = ast_new(AstNodeKind_binary_expr);
-    e->as.binary_expr = calloc(1, sizeof(BinaryExprNode));
+    e->as.binary_expr = arena_alloc(&parse_arena, sizeof(BinaryExprNode));
     e->as.binary_expr->op = op;
     e->as.binary_expr->lhs = lhs;
     e->as.binary_expr->rhs = rhs;
@@ -389,7 +473,7 @@ AstNode* ast_new_binary_expr(int op, AstNode* lhs, AstNode* rhs) {
 
 AstNode* ast_new_assign_expr(int op, AstNode* lhs, AstNode* rhs) {
     AstNode* e = ast_new(AstNodeKind_assign_expr);
-    e->as.assign_expr = calloc(1, sizeof(AssignExprNode));
+    e->as.assign_expr = arena_alloc(&parse_arena, sizeof(AssignExprNode));
     e->as.assign_expr->op = op;
     e->as.assign_expr->lhs = lhs;
     e->as.assign_expr->rhs = rhs;
@@ -415,7 +499,7 @@ AstNode* ast_new_assign_sub_expr(AstNode* lhs, AstNode* rhs) {
 
 AstNode* ast_new_ref_expr(AstNode* operand) {
     AstNode* e = ast_new(AstNodeKind_ref_expr);
-    e->as.ref_expr = calloc(1, sizeof(RefExprNode));
+    e->as.ref_expr = arena_alloc(&parse_arena, sizeof(RefExprNode));
     e->as.ref_expr->operand = operand;
     e->ty = type_new_ptr(operand->ty);
     return e;
@@ -423,7 +507,7 @@ AstNode* ast_new_ref_expr(AstNode* operand) {
 
 AstNode* ast_new_deref_expr(AstNode* operand) {
     AstNode* e = ast_new(AstNodeKind_deref_expr);
-    e->as.deref_expr = calloc(1, sizeof(DerefExprNode));
+    e->as.deref_expr = arena_alloc(&parse_arena, sizeof(DerefExprNode));
     e->as.deref_expr->operand = operand;
     e->ty = operand->ty->base;
     return e;
@@ -431,7 +515,7 @@ AstNode* ast_new_deref_expr(AstNode* operand) {
 
 AstNode* ast_new_member_access_expr(AstNode* obj, const char* name) {
     AstNode* e = ast_new(AstNodeKind_deref_expr);
-    e->as.deref_expr = calloc(1, sizeof(DerefExprNode));
+    e->as.deref_expr = arena_alloc(&parse_arena, sizeof(DerefExprNode));
     e->as.deref_expr->operand =
         ast_new_binary_expr(TokenKind_plus, obj, ast_new_int(type_offsetof(obj->ty->base, name)));
     e->ty = type_member_typeof(obj->ty->base, name);
@@ -441,7 +525,7 @@ AstNode* ast_new_member_access_expr(AstNode* obj, const char* name) {
 
 AstNode* ast_new_cast_expr(AstNode* operand, Type* result_ty) {
     AstNode* e = ast_new(AstNodeKind_cast_expr);
-    e->as.cast_expr = calloc(1, sizeof(CastExprNode));
+    e->as.cast_expr = arena_alloc(&parse_arena, sizeof(CastExprNode));
     e->as.cast_expr->operand = operand;
     e->ty = result_ty;
     return e;
@@ -449,7 +533,7 @@ AstNode* ast_new_cast_expr(AstNode* operand, Type* result_ty) {
 
 AstNode* ast_new_logical_expr(int op, AstNode* lhs, AstNode* rhs) {
     AstNode* e = ast_new(AstNodeKind_logical_expr);
-    e->as.logical_expr = calloc(1, sizeof(LogicalExprNode));
+    e->as.logical_expr = arena_alloc(&parse_arena, sizeof(LogicalExprNode));
     e->as.logical_expr->op = op;
     e->as.logical_expr->lhs = lhs;
     e->as.logical_expr->rhs = rhs;
@@ -459,7 +543,7 @@ AstNode* ast_new_logical_expr(int op, AstNode* lhs, AstNode* rhs) {
 
 AstNode* ast_new_cond_expr(AstNode* cond, AstNode* then, AstNode* else_) {
     AstNode* e = ast_new(AstNodeKind_cond_expr);
-    e->as.cond_expr = calloc(1, sizeof(CondExprNode));
+    e->as.cond_expr = arena_alloc(&parse_arena, sizeof(CondExprNode));
     e->as.cond_expr->cond = cond;
     e->as.cond_expr->then = then;
     e->as.cond_expr->else_ = else_;
@@ -469,7 +553,7 @@ AstNode* ast_new_cond_expr(AstNode* cond, AstNode* then, AstNode* else_) {
 
 AstNode* ast_new_str_expr(int idx, Type* ty) {
     AstNode* e = ast_new(AstNodeKind_str_expr);
-    e->as.str_expr = calloc(1, sizeof(StrExprNode));
+    e->as.str_expr = arena_alloc(&parse_arena, sizeof(StrExprNode));
     e->as.str_expr->idx = idx;
     e->ty = ty;
     return e;
@@ -477,7 +561,7 @@ AstNode* ast_new_str_expr(int idx, Type* ty) {
 
 AstNode* ast_new_func_call(AstNode* func, AstNode* args) {
     AstNode* e = ast_new(AstNodeKind_func_call);
-    e->as.func_call = calloc(1, sizeof(FuncCallNode));
+    e->as.func_call = arena_alloc(&parse_arena, sizeof(FuncCallNode));
     e->as.func_call->func = func;
     e->as.func_call->args = args;
     return e;
@@ -485,7 +569,7 @@ AstNode* ast_new_func_call(AstNode* func, AstNode* args) {
 
 AstNode* ast_new_func(const char* name, Type* ty) {
     AstNode* e = ast_new(AstNodeKind_func);
-    e->as.func = calloc(1, sizeof(FuncNode));
+    e->as.func = arena_alloc(&parse_arena, sizeof(FuncNode));
     e->as.func->name = name;
     e->ty = ty;
     return e;
@@ -493,7 +577,7 @@ AstNode* ast_new_func(const char* name, Type* ty) {
 
 AstNode* ast_new_gvar(const char* name, Type* ty) {
     AstNode* e = ast_new(AstNodeKind_gvar);
-    e->as.gvar = calloc(1, sizeof(GvarNode));
+    e->as.gvar = arena_alloc(&parse_arena, sizeof(GvarNode));
     e->as.gvar->name = name;
     e->ty = ty;
     return e;
@@ -501,7 +585,7 @@ AstNode* ast_new_gvar(const char* name, Type* ty) {
 
 AstNode* ast_new_lvar(const char* name, int stack_offset, Type* ty) {
     AstNode* e = ast_new(AstNodeKind_lvar);
-    e->as.lvar = calloc(1, sizeof(LvarNode));
+    e->as.lvar = arena_alloc(&parse_arena, sizeof(LvarNode));
     e->as.lvar->name = name;
     e->as.lvar->stack_offset = stack_offset;
     e->ty = ty;
@@ -522,21 +606,21 @@ AstNode* ast_new_continue_stmt(void) {
 
 AstNode* ast_new_return_stmt(AstNode* expr) {
     AstNode* e = ast_new(AstNodeKind_return_stmt);
-    e->as.return_stmt = calloc(1, sizeof(ReturnStmtNode));
+    e->as.return_stmt = arena_alloc(&parse_arena, sizeof(ReturnStmtNode));
     e->as.return_stmt->expr = expr;
     return e;
 }
 
 AstNode* ast_new_expr_stmt(AstNode* expr) {
     AstNode* e = ast_new(AstNodeKind_expr_stmt);
-    e->as.expr_stmt = calloc(1, sizeof(ExprStmtNode));
+    e->as.expr_stmt = arena_alloc(&parse_arena, sizeof(ExprStmtNode));
     e->as.expr_stmt->expr = expr;
     return e;
 }
 
 AstNode* ast_new_if_stmt(AstNode* cond, AstNode* then, AstNode* else_) {
     AstNode* e = ast_new(AstNodeKind_if_stmt);
-    e->as.if_stmt = calloc(1, sizeof(IfStmtNode));
+    e->as.if_stmt = arena_alloc(&parse_arena, sizeof(IfStmtNode));
     e->as.if_stmt->cond = cond;
     e->as.if_stmt->then = then;
     e->as.if_stmt->else_ = else_;
@@ -545,7 +629,7 @@ AstNode* ast_new_if_stmt(AstNode* cond, AstNode* then, AstNode* else_) {
 
 AstNode* ast_new_for_stmt(AstNode* init, AstNode* cond, AstNode* update, AstNode* body) {
     AstNode* e = ast_new(AstNodeKind_for_stmt);
-    e->as.for_stmt = calloc(1, sizeof(ForStmtNode));
+    e->as.for_stmt = arena_alloc(&parse_arena, sizeof(ForStmtNode));
     e->as.for_stmt->init = init;
     e->as.for_stmt->cond = cond;
     e->as.for_stmt->update = update;
@@ -555,7 +639,7 @@ AstNode* ast_new_for_stmt(AstNode* init, AstNode* cond, AstNode* update, AstNode
 
 AstNode* ast_new_do_while_stmt(AstNode* cond, AstNode* body) {
     AstNode* e = ast_new(AstNodeKind_do_while_stmt);
-    e->as.do_while_stmt = calloc(1, sizeof(DoWhileStmtNode));
+    e->as.do_while_stmt = arena_alloc(&parse_arena, sizeof(DoWhileStmtNode));
     e->as.do_while_stmt->cond = cond;
     e->as.do_while_stmt->body = body;
     return e;
@@ -563,14 +647,14 @@ AstNode* ast_new_do_while_stmt(AstNode* cond, AstNode* body) {
 
 AstNode* ast_new_switch_stmt(AstNode* expr) {
     AstNode* e = ast_new(AstNodeKind_switch_stmt);
-    e->as.switch_stmt = calloc(1, sizeof(SwitchStmtNode));
+    e->as.switch_stmt = arena_alloc(&parse_arena, sizeof(SwitchStmtNode));
     e->as.switch_stmt->expr = expr;
     return e;
 }
 
 AstNode* ast_new_case_label(int value, AstNode* body) {
     AstNode* e = ast_new(AstNodeKind_case_label);
-    e->as.case_label = calloc(1, sizeof(CaseLabelNode));
+    e->as.case_label = arena_alloc(&parse_arena, sizeof(CaseLabelNode));
     e->as.case_label->value = value;
     e->as.case_label->body = body;
     return e;
@@ -578,21 +662,21 @@ AstNode* ast_new_case_label(int value, AstNode* body) {
 
 AstNode* ast_new_default_label(AstNode* body) {
     AstNode* e = ast_new(AstNodeKind_default_label);
-    e->as.default_label = calloc(1, sizeof(DefaultLabelNode));
+    e->as.default_label = arena_alloc(&parse_arena, sizeof(DefaultLabelNode));
     e->as.default_label->body = body;
     return e;
 }
 
 AstNode* ast_new_goto_stmt(const char* label) {
     AstNode* e = ast_new(AstNodeKind_goto_stmt);
-    e->as.goto_stmt = calloc(1, sizeof(GotoStmtNode));
+    e->as.goto_stmt = arena_alloc(&parse_arena, sizeof(GotoStmtNode));
     e->as.goto_stmt->label = label;
     return e;
 }
 
 AstNode* ast_new_label_stmt(const char* name, AstNode* body) {
     AstNode* e = ast_new(AstNodeKind_label_stmt);
-    e->as.label_stmt = calloc(1, sizeof(LabelStmtNode));
+    e->as.label_stmt = arena_alloc(&parse_arena, sizeof(LabelStmtNode));
     e->as.label_stmt->name = name;
     e->as.label_stmt->body = body;
     return e;
@@ -600,16 +684,18 @@ AstNode* ast_new_label_stmt(const char* name, AstNode* body) {
 
 AstNode* ast_new_declarator(const char* name, Type* ty) {
     AstNode* e = ast_new(AstNodeKind_declarator);
-    e->as.declarator = calloc(1, sizeof(DeclaratorNode));
+    e->as.declarator = arena_alloc(&parse_arena, sizeof(DeclaratorNode));
     e->as.declarator->name = name;
     e->ty = ty;
     return e;
 }
 
-AstNode* ast_new_func_def(const char* name, Type* ty, AstNode* params, AstNode* body, int stack_size) {
+AstNode* ast_new_func_def(const char* name, StorageClass storage_class, Type* ty, AstNode* params, AstNode* body,
+                          int stack_size) {
     AstNode* e = ast_new(AstNodeKind_func_def);
-    e->as.func_def = calloc(1, sizeof(FuncDefNode));
+    e->as.func_def = arena_alloc(&parse_arena, sizeof(FuncDefNode));
     e->as.func_def->name = name;
+    e->as.func_def->storage_class = storage_class;
     e->as.func_def->params = params;
     e->as.func_def->body = body;
     e->as.func_def->stack_size = stack_size;
@@ -619,7 +705,7 @@ AstNode* ast_new_func_def(const char* name, Type* ty, AstNode* params, AstNode*
 
 AstNode* ast_new_enum_member(const char* name, int value) {
     AstNode* e = ast_new(AstNodeKind_enum_member);
-    e->as.enum_member = calloc(1, sizeof(EnumMemberNode));
+    e->as.enum_member = arena_alloc(&parse_arena, sizeof(EnumMemberNode));
     e->as.enum_member->name = name;
     e->as.enum_member->value = value;
     return e;
@@ -627,7 +713,7 @@ AstNode* ast_new_enum_member(const char* name, int value) {
 
 AstNode* ast_new_typedef_decl(const char* name, Type* ty) {
     AstNode* e = ast_new(AstNodeKind_typedef_decl);
-    e->as.typedef_decl = calloc(1, sizeof(TypedefDeclNode));
+    e->as.typedef_decl = arena_alloc(&parse_arena, sizeof(TypedefDeclNode));
     e->as.typedef_decl->name = name;
     e->ty = ty;
     return e;
@@ -635,32 +721,40 @@ AstNode* ast_new_typedef_decl(const char* name, Type* ty) {
 
 AstNode* ast_new_struct_def(const char* name) {
     AstNode* e = ast_new(AstNodeKind_struct_def);
-    e->as.struct_def = calloc(1, sizeof(StructDefNode));
+    e->as.struct_def = arena_alloc(&parse_arena, sizeof(StructDefNode));
     e->as.struct_def->name = name;
     return e;
 }
 
 AstNode* ast_new_union_def(const char* name) {
     AstNode* e = ast_new(AstNodeKind_union_def);
-    e->as.union_def = calloc(1, sizeof(UnionDefNode));
+    e->as.union_def = arena_alloc(&parse_arena, sizeof(UnionDefNode));
     e->as.union_def->name = name;
     return e;
 }
 
 AstNode* ast_new_enum_def(const char* name) {
     AstNode* e = ast_new(AstNodeKind_enum_def);
-    e->as.enum_def = calloc(1, sizeof(EnumDefNode));
+    e->as.enum_def = arena_alloc(&parse_arena, sizeof(EnumDefNode));
     e->as.enum_def->name = name;
     return e;
 }
 
 AstNode* ast_new_array_initializer(AstNode* list) {
     AstNode* e = ast_new(AstNodeKind_array_initializer);
-    e->as.array_initializer = calloc(1, sizeof(ArrayInitializerNode));
+    e->as.array_initializer = arena_alloc(&parse_arena, sizeof(ArrayInitializerNode));
     e->as.array_initializer->list = list;
     return e;
 }
 
+AstNode* ast_new_embedded_data(const char* data, size_t len) {
+    AstNode* e = ast_new(AstNodeKind_embedded_data);
+    e->as.embedded_data = arena_alloc(&parse_arena, sizeof(EmbeddedDataNode));
+    e->as.embedded_data->data = data;
+    e->as.embedded_data->len = len;
+    return e;
+}
+
 int type_sizeof_struct(Type* ty) {
     int next_offset = 0;
     int struct_align = 0;
@@ -757,7 +851,7 @@ int type_offsetof(Type* ty, const char* name) {
         }
 
         next_offset = to_aligned(next_offset, align);
-        if (strcmp(member->as.struct_member->name, name) == 0) {
+        if (member->as.struct_member->name == name) {
             if (member->as.struct_member->is_bitfield) {
                 // C23: 7.21.4
                 // if the specified member is a bit-field, the behavior is undefined.
@@ -778,7 +872,7 @@ Type* type_member_typeof(Type* ty, const char* name) {
 
     for (int i = 0; i < members_of(ty)->as.list->len; ++i) {
         AstNode* member = &members_of(ty)->as.list->items[i];
-        if (strcmp(member->as.struct_member->name, name) == 0) {
+        if (member->as.struct_member->name == name) {
             return member->ty;
         }
     }
@@ -54,9 +54,11 @@ typedef struct {
     size_t index;
 } TypeRef;
 
+// Types are hash-consed: the constructors below return the one canonical object of each type, so two types are the
+// same iff they are ==, and types must not be modified. Function types are not shared, as each has its declaration's
+// parameters. A declaration's storage class is not part of its type; it is kept on the declaration instead.
 typedef struct Type {
     TypeKind kind;
-    StorageClass storage_class;
     // Check `base` instead of `kind` to test if the type is an array or a pointer.
     struct Type* base;
     int array_size;
@@ -65,8 +67,10 @@ typedef struct Type {
     AstNode* params;
 } Type;
 
+// The type of a basic kind, i.e. any kind but struct, union, enum, pointer, array and function.
 Type* type_new(TypeKind kind);
-Type* type_dup(Type* src);
+// The struct, union or enum type defined by the `index`-th item of `defs`.
+Type* type_new_ref(TypeKind kind, AstNode* defs, size_t index);
 Type* type_new_ptr(Type* base);
 Type* type_new_array(Type* elem, int size);
 Type* type_new_static_string(int len);
@@ -102,6 +106,7 @@ typedef enum {
     AstNodeKind_default_label,
     AstNodeKind_deref_expr,
     AstNodeKind_do_while_stmt,
+    AstNodeKind_embedded_data,
     AstNodeKind_enum_def,
     AstNodeKind_enum_member,
     AstNodeKind_expr_stmt,
@@ -253,6 +258,7 @@ typedef struct {
 // Declaration nodes
 typedef struct {
     const char* name;
+    StorageClass storage_class;
     AstNode* params;
     AstNode* body;
     int stack_size;
@@ -274,6 +280,7 @@ typedef struct {
 
 typedef struct {
     const char* name;
+    StorageClass storage_class;
     AstNode* expr;
 } GvarDeclNode;
 
@@ -299,6 +306,7 @@ typedef struct {
 
 typedef struct {
     const char* name;
+    StorageClass storage_class;
     AstNode* init;
 } DeclaratorNode;
 
@@ -325,6 +333,12 @@ typedef struct {
     AstNode* list;
 } ArrayInitializerNode;
 
+// Bytes inserted by #embed in a braced initializer. Each byte initializes one element.
+typedef struct {
+    const char* data;
+    size_t len;
+} EmbeddedDataNode;
+
 typedef struct {
     AstNode* items;
     int len;
@@ -374,6 +388,7 @@ struct AstNode {
         StructMemberNode* struct_member;
         TypedefDeclNode* typedef_decl;
         ArrayInitializerNode* array_initializer;
+        EmbeddedDataNode* embedded_data;
         ListNode* list;
     } as;
 };
@@ -422,12 +437,14 @@ AstNode* ast_new_goto_stmt(const char* label);
 AstNode* ast_new_label_stmt(const char* name, AstNode* body);
 
 AstNode* ast_new_declarator(const char* name, Type* ty);
-AstNode* ast_new_func_def(const char* name, Type* ty, AstNode* params, AstNode* body, int stack_size);
+AstNode* ast_new_func_def(const char* name, StorageClass storage_class, Type* ty, AstNode* params, AstNode* body,
+                          int stack_size);
 AstNode* ast_new_enum_member(const char* name, int value);
 AstNode* ast_new_typedef_decl(const char* name, Type* ty);
 AstNode* ast_new_struct_def(const char* name);
 AstNode* ast_new_union_def(const char* name);
 AstNode* ast_new_enum_def(const char* name);
 AstNode* ast_new_array_initializer(AstNode* list);
+AstNode* ast_new_embedded_data(const char* data, size_t len);
 
 #endif
@@ -0,0 +1,214 @@
+#include "atom.h"
+#include "../lib/arena.h"
+#include "../lib/common.h"
+
+typedef struct {
+    const char* name;
+    int len;
+    unsigned int hash;
+    TokenKind keyword_kind;
+    TokenKind directive_kind;
+} AtomEntry;
+
+typedef struct {
+    // Indexed by ID.
+    AtomEntry* entries;
+    int len;
+    int capacity;
+    // Open-addressing hash table of IDs, -1 for an empty slot. The number of slots is a power of two and at least twice
+    // the number of atoms.
+    int* slots;
+    int slot_count;
+} AtomTable;
+
+static AtomTable atoms;
+
+// FNV-1a
+static unsigned int hash_bytes(const char* s, size_t len) {
+    unsigned int h = 0x811c9dc5;
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ s[i]) * 16777619;
+    }
+    return h;
+}
+
+static void atoms_rehash(int slot_count) {
+    atoms.slot_count = slot_count;
+    atoms.slots = realloc(atoms.slots, slot_count * sizeof(int));
+    memset(atoms.slots, 0xff, slot_count * sizeof(int));
+    for (int id = 0; id < atoms.len; ++id) {
+        int i = atoms.entries[id].hash & (slot_count - 1);
+        while (atoms.slots[i] != -1) {
+            i = (i + 1) & (slot_count - 1);
+        }
+        atoms.slots[i] = id;
+    }
+}
+
+static int atoms_add(const char* s, size_t len, unsigned int hash, int slot) {
+    if (atoms.capacity <= atoms.len) {
+        atoms.capacity *= 2;
+        atoms.entries = realloc(atoms.entries, atoms.capacity * sizeof(AtomEntry));
+    }
+
+    // The ID is stored right before the characters so that atom_id() is a single load.
+    int* header = arena_alloc(&token_arena, sizeof(int) + len + 1);
+    char* name = (char*)(header + 1);
+    memcpy(name, s, len);
+    name[len] = '\0';
+
+    int id = atoms.len;
+    *header = id;
+    AtomEntry* e = &atoms.entries[id];
+    e->name = name;
+    e->len = len;
+    e->hash = hash;
+    e->keyword_kind = TokenKind_ident;
+    e->directive_kind = TokenKind_pp_directive_non_directive;
+    ++atoms.len;
+
+    atoms.slots[slot] = id;
+    if (atoms.slot_count < atoms.len * 2) {
+        atoms_rehash(atoms.slot_count * 2);
+    }
+    return id;
+}
+
+static void atoms_init();
+
+static int intern_id(const char* s, size_t len) {
+    if (!atoms.entries) {
+        atoms_init();
+    }
+
+    unsigned int hash = hash_bytes(s, len);
+    int i = hash & (atoms.slot_count - 1);
+    while (atoms.slots[i] != -1) {
+        AtomEntry* e = &atoms.entries[atoms.slots[i]];
+        if (e->hash == hash && e->len == (int)len && memcmp(e->name, s, len) == 0) {
+            return atoms.slots[i];
+        }
+        i = (i + 1) & (atoms.slot_count - 1);
+    }
+    return atoms_add(s, len, hash, i);
+}
+
+static void seed(const char* name, int expected_id) {
+    int id = intern_id(name, strlen(name));
+    if (id != expected_id) {
+        fatal_error("atom: '%s' is seeded with ID %d, expected %d", name, id, expected_id);
+    }
+}
+
+static void atoms_init() {
+    atoms.capacity = 1024;
+    atoms.entries = calloc(atoms.capacity, sizeof(AtomEntry));
+    atoms_rehash(2048);
+
+    seed("defined", Atom_defined);
+    seed("__has_c_attribute", Atom___has_c_attribute);
+    seed("__has_embed", Atom___has_embed);
+    seed("__has_include", Atom___has_include);
+    seed("__FILE__", Atom___FILE__);
+    seed("__LINE__", Atom___LINE__);
+    seed("__VA_ARGS__", Atom___VA_ARGS__);
+
+    for (int k = TokenKind_pp_directive_define; k <= TokenKind_pp_directive_warning; ++k) {
+        if (k == TokenKind_pp_directive_non_directive || k == TokenKind_pp_directive_nop) {
+            continue;
+        }
+        // Skip '#'.
+        const char* name = token_kind_stringify(k) + 1;
+        int id = intern_id(name, strlen(name));
+        atoms.entries[id].directive_kind = k;
+    }
+    for (int k = TokenKind_keyword_alignas; k <= TokenKind_keyword__Noreturn; ++k) {
+        const char* name = token_kind_stringify(k);
+        int id = intern_id(name, strlen(name));
+        atoms.entries[id].keyword_kind = k;
+    }
+}
+
+const char* atom_intern(const char* s, size_t len) {
+    // intern_id() may grow the entries, so it must be called before `atoms.entries` is read.
+    int id = intern_id(s, len);
+    return atoms.entries[id].name;
+}
+
+const char* atom_intern_string(const char* s) {
+    return atom_intern(s, strlen(s));
+}
+
+int atom_id(const char* atom) {
+    int id = *((const int*)atom - 1);
+    if (id < 0 || atoms.len <= id || atoms.entries[id].name != atom) {
+        fatal_error("%s:%d: '%s' is not an atom", __FILE__, __LINE__, atom);
+    }
+    return id;
+}
+
+size_t atom_hash(const char* atom, int bits) {
+    return hash_mix(atom_id(atom), bits);
+}
+
+void atom_map_init(AtomMap* map, int bits) {
+    map->len = 0;
+    map->bits = bits;
+    map->slots = calloc((size_t)1 << bits, sizeof(AtomMapEntry));
+}
+
+// Returns the slot of `key`, or the empty slot where it would go.
+static AtomMapEntry* atom_map_slot(AtomMap* map, const char* key) {
+    size_t mask = ((size_t)1 << map->bits) - 1;
+    size_t i = atom_hash(key, map->bits);
+    while (map->slots[i].key && map->slots[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return &map->slots[i];
+}
+
+int atom_map_get(AtomMap* map, const char* key) {
+    AtomMapEntry* e = atom_map_slot(map, key);
+    return e->key ? e->value : -1;
+}
+
+AtomMapEntry* atom_map_entry(AtomMap* map, const char* key) {
+    AtomMapEntry* e = atom_map_slot(map, key);
+    if (e->key) {
+        return e;
+    }
+
+    if ((map->len + 1) * 2 > ((size_t)1 << map->bits)) {
+        AtomMapEntry* old_slots = map->slots;
+        size_t old_slot_count = (size_t)1 << map->bits;
+        size_t len = map->len;
+        atom_map_init(map, map->bits + 1);
+        for (size_t i = 0; i < old_slot_count; ++i) {
+            if (old_slots[i].key) {
+                *atom_map_slot(map, old_slots[i].key) = old_slots[i];
+            }
+        }
+        map->len = len;
+        free(old_slots);
+        e = atom_map_slot(map, key);
+    }
+    e->key = key;
+    e->value = -1;
+    ++map->len;
+    return e;
+}
+
+const char* atom_name(int id) {
+    if (!atoms.entries) {
+        atoms_init();
+    }
+    return atoms.entries[id].name;
+}
+
+TokenKind atom_keyword_kind(const char* atom) {
+    return atoms.entries[atom_id(atom)].keyword_kind;
+}
+
+TokenKind atom_directive_kind(const char* atom) {
+    return atoms.entries[atom_id(atom)].directive_kind;
+}
@@ -0,0 +1,57 @@
+#ifndef DUCC_ATOM_H
+#define DUCC_ATOM_H
+
+#include "../lib/ducc.h"
+#include "token.h"
+
+// An atom is the unique copy of an identifier's spelling in the process-wide atom table. Interning the same spelling
+// twice yields the same pointer, so two atoms are equal iff they are ==. The lexer interns every identifier, and so do
+// the few places that make identifiers out of thin air (predefined macros, '##', generated names), which means that
+// identifier token values, macro names and symbol names can all be compared by pointer.
+//
+// Each atom has a small integer ID. The table is seeded with the names below, then the directive names and then the
+// keywords, always in the same order, so these get the same IDs in every run.
+typedef enum {
+    Atom_defined,
+    Atom___has_c_attribute,
+    Atom___has_embed,
+    Atom___has_include,
+    Atom___FILE__,
+    Atom___LINE__,
+    Atom___VA_ARGS__,
+} PredefinedAtom;
+
+const char* atom_intern(const char* s, size_t len);
+const char* atom_intern_string(const char* s);
+int atom_id(const char* atom);
+// A slot in a table of 2^bits slots keyed by atoms. Atoms interned together, such as the macros of a header, have
+// nearby IDs; hash_mix() scatters them.
+size_t atom_hash(const char* atom, int bits);
+const char* atom_name(int id);
+
+typedef struct {
+    const char* key;
+    int value;
+} AtomMapEntry;
+
+// An open-addressing hash table with linear probing from atoms to ints, e.g. indices into an array of definitions. A
+// NULL key marks an empty slot. The table is kept at most half full.
+typedef struct {
+    size_t len;
+    // log2 of the number of slots
+    int bits;
+    AtomMapEntry* slots;
+} AtomMap;
+
+void atom_map_init(AtomMap* map, int bits);
+// The value of `key`, or -1 if it is not in the map.
+int atom_map_get(AtomMap* map, const char* key);
+// The entry of `key`, added with the value -1 if it is not in the map yet. It is valid until the next entry is added.
+AtomMapEntry* atom_map_entry(AtomMap* map, const char* key);
+
+// TokenKind_keyword_* if `atom` is a keyword, TokenKind_ident otherwise.
+TokenKind atom_keyword_kind(const char* atom);
+// TokenKind_pp_directive_* if `atom` is the name of a directive, TokenKind_pp_directive_non_directive otherwise.
+TokenKind atom_directive_kind(const char* atom);
+
+#endif
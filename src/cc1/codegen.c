@@ -1,6 +1,7 @@
 #include "codegen.h"
 #include <stdlib.h>
 #include <string.h>
+#include "../lib/arena.h"
 #include "../lib/common.h"
 #include "parse.h"
 #include "preprocess.h"
@@ -355,7 +356,7 @@ static void codegen_assign_expr(CodeGen* g, AssignExprNode* expr) {
 }
 
 static void codegen_args(CodeGen* g, AstNode* args) {
-    int* required_gp_regs_for_each_arg = calloc(args->as.list->len, sizeof(int));
+    int* required_gp_regs_for_each_arg = arena_calloc(&codegen_arena, args->as.list->len, sizeof(int));
 
     int gp_regs = 6;
     for (int i = 0; i < args->as.list->len; ++i) {
@@ -844,7 +845,7 @@ static void codegen_stmt(CodeGen* g, AstNode* ast) {
 static void codegen_func(CodeGen* g, AstNode* ast) {
     g->current_func = ast;
 
-    if (ast->ty->storage_class != StorageClass_static) {
+    if (ast->as.func_def->storage_class != StorageClass_static) {
         fprintf(g->out, ".globl %s\n", ast->as.func_def->name);
     }
     fprintf(g->out, "%s:\n", ast->as.func_def->name);
@@ -859,13 +860,43 @@ static void codegen_func(CodeGen* g, AstNode* ast) {
 
     fprintf(g->out, "\n");
     g->current_func = NULL;
+    arena_reset(&codegen_arena);
+}
+
+#define CODEGEN_BYTES_PER_LINE 64
+
+// Emits the bytes as .ascii directives, packing up to CODEGEN_BYTES_PER_LINE bytes into one line.
+static void codegen_bytes(CodeGen* g, const char* buf, size_t len) {
+    // Each byte takes at most 4 characters (an octal escape).
+    char line[CODEGEN_BYTES_PER_LINE * 4 + 16];
+    for (size_t start = 0; start < len; start += CODEGEN_BYTES_PER_LINE) {
+        size_t end = start + CODEGEN_BYTES_PER_LINE;
+        if (len < end) {
+            end = len;
+        }
+        int n = 0;
+        for (size_t i = start; i < end; ++i) {
+            int c = buf[i] & 0xff;
+            if (c < 0x20 || 0x7e < c || c == '"' || c == '\\') {
+                line[n++] = '\\';
+                line[n++] = '0' + ((c >> 6) & 7);
+                line[n++] = '0' + ((c >> 3) & 7);
+                line[n++] = '0' + (c & 7);
+            } else {
+                line[n++] = c;
+            }
+        }
+        fprintf(g->out, "    .ascii \"");
+        fwrite(line, 1, n, g->out);
+        fprintf(g->out, "\"\n");
+    }
 }
 
 static void codegen_global_var(CodeGen* g, AstNode* var) {
-    if (var->ty->storage_class == StorageClass_extern) {
+    if (var->as.gvar_decl->storage_class == StorageClass_extern) {
         return;
     }
-    if (var->ty->storage_class != StorageClass_static) {
+    if (var->as.gvar_decl->storage_class != StorageClass_static) {
         fprintf(g->out, ".globl %s\n", var->as.gvar_decl->name);
     }
     fprintf(g->out, "  %s:\n", var->as.gvar_decl->name);
@@ -887,9 +918,7 @@ static void codegen_global_var(CodeGen* g, AstNode* var) {
         if (block->kind == InitDataBlockKind_addr) {
             fprintf(g->out, "    .quad %s\n", block->as.addr.label);
         } else {
-            for (size_t j = 0; j < block->as.bytes.len; ++j) {
-                fprintf(g->out, "    .byte %d\n", block->as.bytes.buf[j]);
-            }
+            codegen_bytes(g, block->as.bytes.buf, block->as.bytes.len);
         }
     }
 }
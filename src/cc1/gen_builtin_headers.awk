@@ -0,0 +1,54 @@
+# Converts ducc's built-in headers into C source so that they can be compiled into the binary.
+# Usage: awk -f gen_builtin_headers.awk include/*.h > builtin_headers.c
+
+function escape(s,    i, c, out) {
+    out = ""
+    for (i = 1; i <= length(s); i++) {
+        c = substr(s, i, 1)
+        if (c == "\\") {
+            out = out "\\\\"
+        } else if (c == "\"") {
+            out = out "\\\""
+        } else if (c == "\t") {
+            out = out "\\t"
+        } else {
+            out = out c
+        }
+    }
+    return out
+}
+
+BEGIN {
+    print "// Generated from include/*.h by src/cc1/gen_builtin_headers.awk. Do not edit."
+    print ""
+    print "const char* builtin_header_contents[] = {"
+    n_files = 0
+}
+
+FNR == 1 {
+    if (n_files > 0) {
+        print ","
+    }
+    n_parts = split(FILENAME, parts, "/")
+    names[n_files] = parts[n_parts]
+    n_files++
+}
+
+{
+    print "    \"" escape($0) "\\n\""
+}
+
+END {
+    if (n_files > 0) {
+        print ","
+    }
+    print "    0,"
+    print "};"
+    print ""
+    print "const char* builtin_header_names[] = {"
+    for (i = 0; i < n_files; i++) {
+        print "    \"" names[i] "\","
+    }
+    print "    0,"
+    print "};"
+}
@@ -1,9 +1,15 @@
 #include "io.h"
+#include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "../lib/common.h"
 #include "../lib/json.h"
+#include "atom.h"
 
 void sourcelocation_build_json(JsonBuilder* builder, SourceLocation* loc) {
     jsonbuilder_object_start(builder);
@@ -16,105 +22,539 @@ void sourcelocation_build_json(JsonBuilder* builder, SourceLocation* loc) {
     jsonbuilder_object_end(builder);
 }
 
-InFile* infile_open(const char* filename) {
-    FILE* in = fopen(filename, "rb");
-    if (!in) {
+// Maps a regular file of `size` bytes so that buf[size] reads as '\0'. When the size is a multiple of the page size,
+// the byte after the contents would fall outside the mapping, so an anonymous region one page larger is reserved first
+// and the file is mapped over its head.
+static char* map_file(int fd, size_t size) {
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t mapped_size = size;
+    if (size % page_size == 0) {
+        mapped_size = size + page_size;
+    }
+
+    char* region = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        return NULL;
+    }
+    char* buf = mmap(region, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (buf == MAP_FAILED) {
+        munmap(region, mapped_size);
+        return NULL;
+    }
+    return buf;
+}
+
+// Fallback for pipes, character devices and anything else mmap() refuses: read the whole stream into a heap buffer
+// followed by a '\0' sentinel.
+static char* read_file(int fd, size_t* out_size) {
+    size_t capacity = 1024 * 16;
+    size_t size = 0;
+    char* buf = malloc(capacity);
+
+    while (1) {
+        if (capacity <= size + 1) {
+            capacity *= 2;
+            buf = realloc(buf, capacity);
+        }
+        ssize_t n = read(fd, buf + size, capacity - size - 1);
+        if (n < 0) {
+            free(buf);
+            return NULL;
+        }
+        if (n == 0) {
+            break;
+        }
+        size += n;
+    }
+    buf[size] = '\0';
+    *out_size = size;
+    return buf;
+}
+
+// Records the start of every physical line and every position infile_peek_char() cannot serve with a plain byte load.
+static void scan_line_structure(SourceText* text) {
+    ints_init(&text->line_starts);
+    ints_init(&text->specials);
+    ints_push(&text->line_starts, 0);
+
+    const char* buf = text->buf;
+    int len = text->len;
+    for (int i = 0; i < len; ++i) {
+        char c = buf[i];
+        if (c == '\n') {
+            ints_push(&text->line_starts, i + 1);
+        } else if (c == '\r') {
+            ints_push(&text->specials, i);
+            if (buf[i + 1] == '\n') {
+                ++i; // CRLF
+            }
+            ints_push(&text->line_starts, i + 1);
+        } else if (c == '\\') {
+            char c2 = buf[i + 1];
+            if (c2 == '\0') {
+                // Backslash at the end of the file. It is reported when the lexer reaches it.
+                ints_push(&text->specials, i);
+            } else if (c2 == '\n' || c2 == '\r') {
+                ints_push(&text->specials, i);
+                if (c2 == '\r' && buf[i + 2] == '\n') {
+                    i += 2; // Backslash + CRLF
+                } else {
+                    i += 1; // Backslash + LF, or backslash + CR
+                }
+                ints_push(&text->line_starts, i + 1);
+            }
+        }
+    }
+    ints_push(&text->specials, INT_MAX);
+}
+
+const char* file_map_contents(const char* filename, size_t* out_size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    char* buf = NULL;
+    size_t size = 0;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        size = st.st_size;
+        buf = map_file(fd, size);
+    }
+    if (!buf) {
+        buf = read_file(fd, &size);
+    }
+    close(fd);
+    *out_size = size;
+    return buf;
+}
+
+int file_probe_contents(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    int result;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        result = st.st_size > 0;
+    } else {
+        // The size of a pipe or a device is not known until it is read.
+        char c;
+        result = read(fd, &c, 1) > 0;
+    }
+    close(fd);
+    return result;
+}
+
+static SourceText* source_text_load(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    char* buf = NULL;
+    size_t size = 0;
+    bool mapped = false;
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        size = st.st_size;
+        buf = map_file(fd, size);
+        mapped = buf != NULL;
+    }
+    if (!buf) {
+        buf = read_file(fd, &size);
+    }
+    close(fd);
+    if (!buf) {
         return NULL;
     }
 
-    size_t buf_size = 1024 * 10;
-    char* buf = calloc(buf_size, sizeof(char));
-    char* cur = buf;
-    char* tmp = calloc(1024, sizeof(char));
+    SourceText* text = calloc(1, sizeof(SourceText));
+    text->buf = buf;
+    text->len = size;
+    text->mapped = mapped;
+    text->dev = st.st_dev;
+    text->ino = st.st_ino;
+    text->mtime_sec = st.st_mtim.tv_sec;
+    text->mtime_nsec = st.st_mtim.tv_nsec;
+    scan_line_structure(text);
+    return text;
+}
+
+static bool source_text_is_up_to_date(SourceText* text, struct stat* st) {
+    return text->dev == (long)st->st_dev && text->ino == (long)st->st_ino && text->len == (size_t)st->st_size &&
+           text->mtime_sec == st->st_mtim.tv_sec && text->mtime_nsec == st->st_mtim.tv_nsec;
+}
+
+typedef struct {
+    size_t len;
+    size_t capacity;
+    SourceText** data;
+} SourceTextArray;
+
+// Process-wide cache of loaded regular files, indexed by canonical path, an atom. Entries are never freed because an
+// InFile opened earlier may still be reading an entry that has since been replaced.
+static SourceTextArray source_cache;
+static AtomMap source_cache_index;
+static SourceCacheStats source_cache_counters;
+
+static void source_cache_push(SourceText* text) {
+    if (source_cache.capacity <= source_cache.len) {
+        source_cache.capacity = source_cache.capacity == 0 ? 32 : source_cache.capacity * 2;
+        source_cache.data = realloc(source_cache.data, source_cache.capacity * sizeof(SourceText*));
+    }
+    source_cache.data[source_cache.len] = text;
+    ++source_cache.len;
+}
+
+// Returns the index entry of `path`, whose value is -1 if the file has not been cached yet.
+static AtomMapEntry* source_cache_find(const char* path) {
+    if (!source_cache_index.slots) {
+        atom_map_init(&source_cache_index, 6);
+    }
+    return atom_map_entry(&source_cache_index, path);
+}
+
+// Stores `text` in `entry`, which source_cache_find() returned for text->path.
+static void source_cache_put(AtomMapEntry* entry, SourceText* text) {
+    if (entry->value == -1) {
+        entry->value = source_cache.len;
+        source_cache_push(text);
+    } else {
+        source_cache.data[entry->value] = text;
+    }
+}
+
+// Returns the contents of the regular file at canonical path `path` whose current status is `st`, loading it on a miss.
+static SourceText* source_cache_get(const char* path, struct stat* st) {
+    AtomMapEntry* entry = source_cache_find(path);
+    SourceText* text = entry->value == -1 ? NULL : source_cache.data[entry->value];
+    if (text && source_text_is_up_to_date(text, st)) {
+        ++source_cache_counters.hits;
+        return text;
+    }
+
+    ++source_cache_counters.misses;
+    if (text) {
+        ++source_cache_counters.invalidations;
+    }
+    SourceText* loaded = source_text_load(path);
+    if (!loaded) {
+        return NULL;
+    }
+    loaded->path = path;
+    source_cache_put(entry, loaded);
+    return loaded;
+}
 
-    while (fgets(tmp, 1024, in)) {
-        size_t len = strlen(tmp);
-        size_t used_size = cur - buf;
+// Defined in the source generated from include/*.h by gen_builtin_headers.awk. Both are terminated by NULL.
+extern const char* builtin_header_names[];
+extern const char* builtin_header_contents[];
 
-        if (buf_size <= used_size + len) {
-            size_t old_size = buf_size;
-            buf_size *= 2;
-            buf = realloc(buf, buf_size);
-            memset(buf + old_size, 0, buf_size - old_size);
-            cur = buf + used_size;
+static const char* find_builtin_header(const char* filename) {
+    if (!str_starts_with(filename, BUILTIN_INCLUDE_DIR "/")) {
+        return NULL;
+    }
+    const char* name = filename + strlen(BUILTIN_INCLUDE_DIR "/");
+    for (int i = 0; builtin_header_names[i]; ++i) {
+        if (strcmp(builtin_header_names[i], name) == 0) {
+            return builtin_header_contents[i];
         }
+    }
+    return NULL;
+}
+
+bool infile_is_builtin(const char* filename) {
+    return str_starts_with(filename, BUILTIN_INCLUDE_DIR "/");
+}
+
+bool infile_exists(const char* filename) {
+    if (infile_is_builtin(filename)) {
+        return find_builtin_header(filename) != NULL;
+    }
+    return access(filename, F_OK | R_OK) == 0;
+}
+
+// Canonical paths by the name they were asked for, as atom IDs. Resolving a name costs a system call per component of
+// the path, and a header is usually named the same way every time it is included.
+static AtomMap canonical_paths;
+
+const char* infile_canonical_path(const char* filename) {
+    const char* name = atom_intern_string(filename);
+    if (infile_is_builtin(filename)) {
+        return name;
+    }
+    if (!canonical_paths.slots) {
+        atom_map_init(&canonical_paths, 6);
+    }
+    AtomMapEntry* entry = atom_map_entry(&canonical_paths, name);
+    if (entry->value != -1) {
+        return atom_name(entry->value);
+    }
 
-        memcpy(cur, tmp, len);
-        cur += len;
+    char* resolved = realpath(filename, NULL);
+    const char* path = name;
+    if (resolved) {
+        path = atom_intern_string(resolved);
+        free(resolved);
+    }
+    // Interning the path may have added to the atom table, but not to this map, so `entry` is still valid.
+    entry->value = atom_id(path);
+    return path;
+}
+
+const char* infile_path(InFile* f) {
+    return f->text->path ? f->text->path : infile_canonical_path(f->filename);
+}
+
+// Built-in headers share the process-wide cache, keyed by their virtual path. They never change, so no status check is
+// needed.
+static SourceText* builtin_header_get(const char* filename) {
+    const char* contents = find_builtin_header(filename);
+    if (!contents) {
+        return NULL;
+    }
+
+    const char* path = atom_intern_string(filename);
+    AtomMapEntry* entry = source_cache_find(path);
+    if (entry->value != -1) {
+        ++source_cache_counters.hits;
+        return source_cache.data[entry->value];
+    }
+
+    ++source_cache_counters.misses;
+    SourceText* text = calloc(1, sizeof(SourceText));
+    text->path = path;
+    text->buf = contents;
+    text->len = strlen(contents);
+    scan_line_structure(text);
+    source_cache_put(entry, text);
+    return text;
+}
+
+const SourceCacheStats* source_cache_stats() {
+    return &source_cache_counters;
+}
+
+// Every InFile ever opened, in the order of their `base`, so that a SourcePos can be mapped back to its file.
+typedef struct {
+    size_t len;
+    size_t capacity;
+    InFile** data;
+} InFileArray;
+
+static InFileArray opened_files;
+// Position 0 is reserved for "no position".
+static SourcePos next_source_pos = 1;
+
+static void opened_files_push(InFile* f) {
+    if (opened_files.capacity <= opened_files.len) {
+        opened_files.capacity = opened_files.capacity == 0 ? 16 : opened_files.capacity * 2;
+        opened_files.data = realloc(opened_files.data, opened_files.capacity * sizeof(InFile*));
+    }
+    opened_files.data[opened_files.len++] = f;
+}
+
+size_t infile_opened_count() {
+    return opened_files.len;
+}
+
+InFile* infile_opened_at(size_t i) {
+    return opened_files.data[i];
+}
+
+static InFile* infile_new(SourceText* text, const char* filename) {
+    // One extra position for the end of input. Positions are kept below INT_MAX so that they never wrap.
+    if (text->len >= (size_t)(INT_MAX - next_source_pos)) {
+        fatal_error("%s: too much source text in a translation unit", filename);
     }
-    fclose(in);
 
     InFile* in_file = calloc(1, sizeof(InFile));
-    in_file->buf = buf;
-    in_file->loc.filename = filename;
-    in_file->loc.line = 1;
+    in_file->text = text;
+    in_file->buf = text->buf;
+    in_file->specials = text->specials.data;
+    in_file->filename = filename;
+    in_file->base = next_source_pos;
+    next_source_pos += text->len + 1;
+    opened_files_push(in_file);
     return in_file;
 }
 
+InFile* infile_open(const char* filename) {
+    if (infile_is_builtin(filename)) {
+        SourceText* text = builtin_header_get(filename);
+        if (!text) {
+            return NULL;
+        }
+        return infile_new(text, filename);
+    }
+
+    struct stat st;
+    if (stat(filename, &st) != 0) {
+        return NULL;
+    }
+
+    SourceText* text;
+    if (S_ISREG(st.st_mode)) {
+        text = source_cache_get(infile_canonical_path(filename), &st);
+    } else {
+        // Pipes and devices cannot be read twice; load them without caching.
+        text = source_text_load(filename);
+    }
+    if (!text) {
+        return NULL;
+    }
+
+    return infile_new(text, filename);
+}
+
 bool infile_eof(InFile* f) {
     return f->buf[f->pos] == '\0';
 }
 
-char infile_peek_char(InFile* f) {
-    char c = f->buf[f->pos];
+static int line_at(InFile* f, int pos) {
+    int* starts = f->text->line_starts.data;
+    int n = f->text->line_starts.len;
+    int i = f->line_hint;
+    if (pos < starts[i]) {
+        // Moved backwards; binary search the lines before the hint.
+        int lo = 0;
+        int hi = i;
+        while (lo + 1 < hi) {
+            int mid = (lo + hi) / 2;
+            if (starts[mid] <= pos) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        i = lo;
+    } else {
+        while (i + 1 < n && starts[i + 1] <= pos) {
+            ++i;
+        }
+    }
+    f->line_hint = i;
+    return i + 1;
+}
+
+SourcePos infile_source_pos(InFile* f) {
+    return f->base + f->pos;
+}
+
+SourceLocation source_pos_decode(SourcePos pos) {
+    SourceLocation loc;
+    if (pos == 0) {
+        loc.filename = NULL;
+        loc.line = 0;
+        return loc;
+    }
+
+    // Find the last file whose range starts at or before `pos`.
+    size_t lo = 0;
+    size_t hi = opened_files.len;
+    while (lo + 1 < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (opened_files.data[mid]->base <= pos) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    InFile* f = opened_files.data[lo];
+    loc.filename = f->filename;
+    loc.line = line_at(f, pos - f->base);
+    return loc;
+}
+
+// Slow path of infile_peek_char(), taken when *pos is at an entry of `specials`. *pos and *index are a cursor into the
+// buffer and into `specials` respectively.
+static char peek_char_at(InFile* f, int* pos, int* index) {
+    while (*pos == f->specials[*index]) {
+        const char* p = f->buf + *pos;
+
+        // Normalize new-line.
+        if (p[0] == '\r') {
+            return '\n';
+        }
 
-    // Skip a pair of backslash and new-line.
-    if (c == '\\') {
-        char c2 = f->buf[f->pos + 1];
+        // Skip a pair of backslash and new-line.
         // C23: 5.1.1.2
         // A source file that is not empty shall end in a new-line character, which shall not be immediately preceded by
         // a backslash character before any such splicing takes place.
-        if (c2 == '\0') {
-            fatal_error("%s:%d: <new-line> expected, but got <eof>", f->loc.filename, f->loc.line);
+        if (p[1] == '\0') {
+            fatal_error("%s:%d: <new-line> expected, but got <eof>", f->filename, line_at(f, *pos));
         }
-        // Handle line continuation.
-        if (c2 == '\r') {
-            if (f->buf[f->pos + 2] == '\n') {
-                f->pos += 3; // Backslash + CRLF
-            } else {
-                f->pos += 2; // Backslash + CR
-            }
-            ++f->loc.line;
-            return infile_peek_char(f);
-        } else if (c2 == '\n') {
-            f->pos += 2; // Backslash + LF
-            ++f->loc.line;
-            return infile_peek_char(f);
+        if (p[1] == '\r' && p[2] == '\n') {
+            *pos += 3; // Backslash + CRLF
+        } else {
+            *pos += 2; // Backslash + LF, or backslash + CR
         }
+        *index += 1;
     }
+    return f->buf[*pos];
+}
 
-    // Normalize new-line.
-    if (c == '\r')
-        c = '\n';
+static char next_char_at(InFile* f, int* pos, int* index) {
+    char c = peek_char_at(f, pos, index);
+    if (*pos == f->specials[*index]) {
+        // CR or CRLF
+        if (f->buf[*pos + 1] == '\n') {
+            *pos += 2;
+        } else {
+            *pos += 1;
+        }
+        *index += 1;
+    } else {
+        *pos += 1;
+    }
     return c;
 }
 
-char infile_next_char(InFile* f) {
-    char c = infile_peek_char(f);
+char infile_peek_char(InFile* f) {
+    if (f->pos < f->specials[f->special_index]) {
+        return f->buf[f->pos];
+    }
+    return peek_char_at(f, &f->pos, &f->special_index);
+}
 
-    if (f->buf[f->pos] == '\r') {
-        ++f->pos;
-        if (f->buf[f->pos] == '\n') {
-            ++f->pos; // CRLF
-        }
-        c = '\n';
-    } else {
+char infile_next_char(InFile* f) {
+    if (f->pos < f->specials[f->special_index]) {
+        char c = f->buf[f->pos];
         ++f->pos;
+        return c;
     }
-
-    if (c == '\n')
-        ++f->loc.line;
-    return c;
+    return next_char_at(f, &f->pos, &f->special_index);
 }
 
 char infile_peek_char2(InFile* f) {
-    int saved_pos = f->pos;
-    int saved_line = f->loc.line;
-    infile_next_char(f);
-    char c = infile_peek_char(f);
-    f->pos = saved_pos;
-    f->loc.line = saved_line;
-    return c;
+    int pos = f->pos;
+    int index = f->special_index;
+    next_char_at(f, &pos, &index);
+    return peek_char_at(f, &pos, &index);
+}
+
+const char* infile_raw(InFile* f) {
+    return f->buf + f->pos;
+}
+
+const char* infile_raw_end(InFile* f) {
+    int end = f->specials[f->special_index];
+    if ((int)f->text->len < end) {
+        end = f->text->len;
+    }
+    return f->buf + end;
+}
+
+void infile_advance_raw(InFile* f, int n) {
+    f->pos += n;
 }
 
 bool infile_consume_if(InFile* f, char expected) {
@@ -1,6 +1,7 @@
 #ifndef DUCC_IO_H
 #define DUCC_IO_H
 
+#include "../lib/common.h"
 #include "../lib/json.h"
 
 typedef struct {
@@ -10,17 +11,99 @@ typedef struct {
 
 void sourcelocation_build_json(JsonBuilder* builder, SourceLocation* loc);
 
+// A source position packed into 32 bits. Every opened InFile is given its own range of positions, one per byte plus one
+// for the end of input, so a position identifies both the file and the offset in it. The filename and line are looked
+// up only when needed, by source_pos_decode(). 0 means "no position".
+typedef unsigned int SourcePos;
+
+SourceLocation source_pos_decode(SourcePos pos);
+
+// Contents of a source file. `buf` is either mmap()-ed directly from the file or, for non-regular files, read into the
+// heap. In both cases buf[len] is '\0', which the lexer relies on to detect the end of input.
+//
+// The buffer is scanned once when the file is loaded. Every position where reading a character takes more than a plain
+// byte load (the backslash of a line splice, or a CR to be normalized) is recorded in `specials`, so that the common
+// path of infile_peek_char() is a single comparison against the next such position. Line numbers are not tracked while
+// reading; source_pos_decode() derives them from `line_starts` on demand.
+//
+// A SourceText is immutable once loaded and is shared by every InFile opened on the same file.
 typedef struct {
+    // Canonical path as an atom, or NULL if the file is not cached (e.g. a pipe).
+    const char* path;
     const char* buf;
+    size_t len;
+    bool mapped;
+    // Offset of the first byte of each physical line, in ascending order.
+    IntArray line_starts;
+    // Offsets of line splices and CRs in ascending order, terminated by INT_MAX.
+    IntArray specials;
+    // Identity of the file at load time, used to detect modification.
+    long dev;
+    long ino;
+    long mtime_sec;
+    long mtime_nsec;
+} SourceText;
+
+// Read cursor over a SourceText.
+typedef struct {
+    const SourceText* text;
+    // Copies of text->buf and text->specials.data.
+    const char* buf;
+    const int* specials;
     int pos;
-    SourceLocation loc;
+    // Index of the first entry in `specials` that is not before `pos`.
+    int special_index;
+    // Index into text->line_starts of the line found by the last lookup, which is usually close to the next one.
+    int line_hint;
+    const char* filename;
+    // SourcePos of the first byte.
+    SourcePos base;
 } InFile;
 
+typedef struct {
+    int hits;
+    int misses;
+    // Cached entries reloaded because the file changed on disk. Also counted in `misses`.
+    int invalidations;
+} SourceCacheStats;
+
+// Ducc's built-in headers (include/*.h) are compiled into the binary and served from memory under this virtual
+// directory, e.g. "<built-in>/stddef.h".
+#define BUILTIN_INCLUDE_DIR "<built-in>"
+
+bool infile_is_builtin(const char* filename);
+bool infile_exists(const char* filename);
+// The same path for every name of the same file, e.g. "dir/../a.h" and "a.h", as an atom. Falls back to `filename`
+// itself if it cannot be resolved. Each name is resolved only once.
+const char* infile_canonical_path(const char* filename);
+// The canonical path of the file `f` reads.
+const char* infile_path(InFile* f);
 InFile* infile_open(const char* filename);
 bool infile_eof(InFile* f);
 char infile_peek_char(InFile* f);
 char infile_peek_char2(InFile* f);
 char infile_next_char(InFile* f);
 bool infile_consume_if(InFile* f, char expected);
+SourcePos infile_source_pos(InFile* f);
+
+// Every InFile opened so far, in the order they were opened, which is also the order of their positions. Opening the
+// same files again in the same order in another run gives them the same positions.
+size_t infile_opened_count();
+InFile* infile_opened_at(size_t i);
+
+// Maps or reads the whole of a file that is not source text, e.g. a precompiled header. The contents are followed by
+// '\0'. Returns NULL if the file cannot be read.
+const char* file_map_contents(const char* filename, size_t* out_size);
+// Whether a file can be read and has any contents, without reading it if it is a regular file: -1 if it cannot be
+// opened, 0 if it is empty and 1 otherwise.
+int file_probe_contents(const char* filename);
+
+// Direct access to the buffer for bulk scanning. Bytes in [infile_raw(f), infile_raw_end(f)) contain no line splice or
+// CR, so they read the same through infile_next_char() as they do in the buffer.
+const char* infile_raw(InFile* f);
+const char* infile_raw_end(InFile* f);
+void infile_advance_raw(InFile* f, int n);
+
+const SourceCacheStats* source_cache_stats();
 
 #endif
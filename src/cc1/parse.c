@@ -1,5 +1,7 @@
 #include "parse.h"
+#include "../lib/arena.h"
 #include "../lib/common.h"
+#include "atom.h"
 #include "tokenize.h"
 
 typedef struct {
@@ -35,9 +37,15 @@ static LocalVar* lvars_push_new(LocalVarArray* lvars) {
     return &lvars->data[lvars->len++];
 }
 
+// A local variable's binding in a block scope. The bindings of the open scopes form a stack, innermost last.
 typedef struct {
     const char* name;
+    // The variable in Parser.lvars.
     int index;
+    // The nesting level of the scope, 1 for the outermost scope of a function.
+    int depth;
+    // The binding of the same name that this one shadows, or -1.
+    int shadowed;
 } ScopedSymbol;
 
 typedef struct {
@@ -67,10 +75,62 @@ static ScopedSymbol* scopedsymbols_push_new(ScopedSymbolArray* syms) {
     return &syms->data[syms->len++];
 }
 
-typedef struct Scope {
-    struct Scope* outer;
-    ScopedSymbolArray syms;
-} Scope;
+static ScopedSymbol* scopedsymbols_pop(ScopedSymbolArray* syms) {
+    return &syms->data[--syms->len];
+}
+
+// A symbol table maps names to the indices of their definitions. Names are never removed; an entry whose value is -1
+// holds a name that is not bound. Returns the index bound to `name`, or -1.
+static int symbols_find(AtomMap* syms, const char* name) {
+    if (!name) {
+        return -1;
+    }
+    return atom_map_get(syms, name);
+}
+
+// Binds `name` to `index` unless it is already bound: lookups find the first definition of a name.
+static void symbols_add(AtomMap* syms, const char* name, int index) {
+    if (!name) {
+        return;
+    }
+    AtomMapEntry* sym = atom_map_entry(syms, name);
+    if (sym->value == -1) {
+        sym->value = index;
+    }
+}
+
+// An enumeration constant: the `member_index`-th member of the `enum_index`-th enum.
+typedef struct {
+    int enum_index;
+    int member_index;
+} EnumMemberRef;
+
+typedef struct {
+    size_t len;
+    size_t capacity;
+    EnumMemberRef* data;
+} EnumMemberRefArray;
+
+static void enummemberrefs_init(EnumMemberRefArray* refs) {
+    refs->len = 0;
+    refs->capacity = 16;
+    refs->data = calloc(refs->capacity, sizeof(EnumMemberRef));
+}
+
+static void enummemberrefs_reserve(EnumMemberRefArray* refs, size_t size) {
+    if (size <= refs->capacity)
+        return;
+    while (refs->capacity < size) {
+        refs->capacity *= 2;
+    }
+    refs->data = realloc(refs->data, refs->capacity * sizeof(EnumMemberRef));
+    memset(refs->data + refs->len, 0, (refs->capacity - refs->len) * sizeof(EnumMemberRef));
+}
+
+static EnumMemberRef* enummemberrefs_push_new(EnumMemberRefArray* refs) {
+    enummemberrefs_reserve(refs, refs->len + 1);
+    return &refs->data[refs->len++];
+}
 
 typedef struct {
     const char* name;
@@ -140,36 +200,60 @@ typedef struct {
     TokenArray* tokens;
     int pos;
     LocalVarArray lvars;
-    Scope* scope;
+    // The bindings of the local variables in the open block scopes, and the innermost binding of each name.
+    ScopedSymbolArray scoped_syms;
+    AtomMap lvar_syms;
+    // 0 at file scope.
+    int scope_depth;
     GlobalVarArray gvars;
+    AtomMap gvar_syms;
     FuncArray funcs;
+    AtomMap func_syms;
     AstNode* structs;
+    AtomMap struct_syms;
     AstNode* unions;
+    AtomMap union_syms;
     AstNode* enums;
+    AtomMap enum_syms;
+    EnumMemberRefArray enum_members;
+    AtomMap enum_member_syms;
     AstNode* typedefs;
+    AtomMap typedef_syms;
     StrArray str_literals;
     int anonymous_user_type_counter;
     AstNode* current_switch;
 } Parser;
 
+static void register_func(Parser* p, const char* name, Type* ty) {
+    Func* func = funcs_push_new(&p->funcs);
+    func->name = name;
+    func->ty = ty;
+    symbols_add(&p->func_syms, name, p->funcs.len - 1);
+}
+
 static Parser* parser_new(TokenArray* tokens) {
-    Parser* p = calloc(1, sizeof(Parser));
+    Parser* p = arena_alloc(&parse_arena, sizeof(Parser));
     p->tokens = tokens;
+    scopedsymbols_init(&p->scoped_syms);
+    atom_map_init(&p->lvar_syms, 6);
     gvars_init(&p->gvars);
+    atom_map_init(&p->gvar_syms, 6);
     funcs_init(&p->funcs);
+    atom_map_init(&p->func_syms, 6);
     p->structs = ast_new_list(4);
+    atom_map_init(&p->struct_syms, 4);
     p->unions = ast_new_list(4);
+    atom_map_init(&p->union_syms, 4);
     p->enums = ast_new_list(4);
+    atom_map_init(&p->enum_syms, 4);
+    enummemberrefs_init(&p->enum_members);
+    atom_map_init(&p->enum_member_syms, 6);
     p->typedefs = ast_new_list(16);
+    atom_map_init(&p->typedef_syms, 6);
     strings_init(&p->str_literals);
 
-    Func* va_start_func = funcs_push_new(&p->funcs);
-    va_start_func->name = "__ducc_va_start";
-    va_start_func->ty = type_new_func(type_new(TypeKind_void), NULL);
-
-    Func* va_arg_func = funcs_push_new(&p->funcs);
-    va_arg_func->name = "__ducc_va_arg";
-    va_arg_func->ty = type_new_func(type_new_ptr(type_new(TypeKind_void)), NULL);
+    register_func(p, atom_intern_string("__ducc_va_start"), type_new_func(type_new(TypeKind_void), NULL));
+    register_func(p, atom_intern_string("__ducc_va_arg"), type_new_func(type_new_ptr(type_new(TypeKind_void)), NULL));
 
     return p;
 }
@@ -183,7 +267,7 @@ static Token* peek_token2(Parser* p) {
 }
 
 static SourceLocation current_location(Parser* p) {
-    return peek_token(p)->loc;
+    return source_pos_decode(peek_token(p)->pos);
 }
 
 static Token* next_token(Parser* p) {
@@ -207,33 +291,24 @@ static Token* expect(Parser* p, TokenKind expected) {
     if (t->kind == expected) {
         return t;
     }
-    fatal_error("%s:%d: expected '%s', but got '%s'", t->loc.filename, t->loc.line, token_kind_stringify(expected),
+    fatal_error("%s:%d: expected '%s', but got '%s'", token_filename(t), token_line(t), token_kind_stringify(expected),
                 token_stringify(t));
 }
 
-static int find_lvar_in_scope(Parser*, Scope* scope, const char* name) {
-    for (size_t i = 0; i < scope->syms.len; ++i) {
-        ScopedSymbol* sym = &scope->syms.data[i];
-        if (sym->name && strcmp(sym->name, name) == 0) {
-            return sym->index;
-        }
-    }
-    return -1;
-}
-
 static int find_lvar_in_current_scope(Parser* p, const char* name) {
-    return find_lvar_in_scope(p, p->scope, name);
+    int sym_idx = symbols_find(&p->lvar_syms, name);
+    if (sym_idx == -1 || p->scoped_syms.data[sym_idx].depth != p->scope_depth) {
+        return -1;
+    }
+    return p->scoped_syms.data[sym_idx].index;
 }
 
 static int find_lvar(Parser* p, const char* name) {
-    Scope* scope = p->scope;
-    while (scope) {
-        int idx = find_lvar_in_scope(p, scope, name);
-        if (idx != -1)
-            return idx;
-        scope = scope->outer;
+    int sym_idx = symbols_find(&p->lvar_syms, name);
+    if (sym_idx == -1) {
+        return -1;
     }
-    return -1;
+    return p->scoped_syms.data[sym_idx].index;
 }
 
 static int calc_lvar_stack_offset(Parser* p, Type* ty) {
@@ -254,9 +329,21 @@ static int add_lvar(Parser* p, const char* name, Type* ty, int stack_offset) {
     lvar->name = name;
     lvar->ty = ty;
     lvar->stack_offset = stack_offset;
-    ScopedSymbol* sym = scopedsymbols_push_new(&p->scope->syms);
+    if (!name) {
+        return stack_offset;
+    }
+
+    AtomMapEntry* entry = atom_map_entry(&p->lvar_syms, name);
+    // A name declared twice in the same scope keeps its first variable.
+    if (entry->value != -1 && p->scoped_syms.data[entry->value].depth == p->scope_depth) {
+        return stack_offset;
+    }
+    ScopedSymbol* sym = scopedsymbols_push_new(&p->scoped_syms);
     sym->name = name;
     sym->index = p->lvars.len - 1;
+    sym->depth = p->scope_depth;
+    sym->shadowed = entry->value;
+    entry->value = p->scoped_syms.len - 1;
     return stack_offset;
 }
 
@@ -266,82 +353,66 @@ static AstNode* generate_temporary_lvar(Parser* p, Type* ty) {
 }
 
 static int find_gvar(Parser* p, const char* name) {
-    for (size_t i = 0; i < p->gvars.len; ++i) {
-        if (strcmp(p->gvars.data[i].name, name) == 0) {
-            return i;
-        }
-    }
-    return -1;
+    return symbols_find(&p->gvar_syms, name);
 }
 
 static int find_func(Parser* p, const char* name) {
-    for (size_t i = 0; i < p->funcs.len; ++i) {
-        if (strcmp(p->funcs.data[i].name, name) == 0) {
-            return i;
-        }
-    }
-    return -1;
+    return symbols_find(&p->func_syms, name);
 }
 
 static int find_struct(Parser* p, const char* name) {
-    for (int i = 0; i < p->structs->as.list->len; ++i) {
-        if (strcmp(p->structs->as.list->items[i].as.struct_def->name, name) == 0) {
-            return i;
-        }
-    }
-    return -1;
+    return symbols_find(&p->struct_syms, name);
 }
 
 static int find_union(Parser* p, const char* name) {
-    for (int i = 0; i < p->unions->as.list->len; ++i) {
-        if (strcmp(p->unions->as.list->items[i].as.union_def->name, name) == 0) {
-            return i;
-        }
-    }
-    return -1;
+    return symbols_find(&p->union_syms, name);
 }
 
 static int find_enum(Parser* p, const char* name) {
-    for (int i = 0; i < p->enums->as.list->len; ++i) {
-        if (strcmp(p->enums->as.list->items[i].as.enum_def->name, name) == 0) {
-            return i;
-        }
-    }
-    return -1;
+    return symbols_find(&p->enum_syms, name);
 }
 
+// Returns the index of the enumeration constant `name` in Parser.enum_members, or -1.
 static int find_enum_member(Parser* p, const char* name) {
-    for (int i = 0; i < p->enums->as.list->len; ++i) {
-        AstNode* members = p->enums->as.list->items[i].as.enum_def->members;
-        if (!members)
-            continue;
-        for (int j = 0; j < members->as.list->len; ++j) {
-            if (strcmp(members->as.list->items[j].as.enum_member->name, name) == 0) {
-                return i * 1000 + j;
-            }
-        }
-    }
-    return -1;
+    return symbols_find(&p->enum_member_syms, name);
 }
 
 static int find_typedef(Parser* p, const char* name) {
-    for (int i = 0; i < p->typedefs->as.list->len; ++i) {
-        if (strcmp(p->typedefs->as.list->items[i].as.typedef_decl->name, name) == 0) {
-            return i;
-        }
-    }
-    return -1;
+    return symbols_find(&p->typedef_syms, name);
+}
+
+static int register_struct(Parser* p, const char* name) {
+    ast_append(p->structs, ast_new_struct_def(name));
+    int struct_idx = p->structs->as.list->len - 1;
+    symbols_add(&p->struct_syms, name, struct_idx);
+    return struct_idx;
+}
+
+static int register_union(Parser* p, const char* name) {
+    ast_append(p->unions, ast_new_union_def(name));
+    int union_idx = p->unions->as.list->len - 1;
+    symbols_add(&p->union_syms, name, union_idx);
+    return union_idx;
+}
+
+static int register_enum(Parser* p, const char* name) {
+    ast_append(p->enums, ast_new_enum_def(name));
+    int enum_idx = p->enums->as.list->len - 1;
+    symbols_add(&p->enum_syms, name, enum_idx);
+    return enum_idx;
 }
 
 static void enter_scope(Parser* p) {
-    Scope* outer_scope = p->scope;
-    p->scope = calloc(1, sizeof(Scope));
-    p->scope->outer = outer_scope;
-    scopedsymbols_init(&p->scope->syms);
+    ++p->scope_depth;
 }
 
+// Drops the bindings of the innermost scope, uncovering the ones they shadowed.
 static void leave_scope(Parser* p) {
-    p->scope = p->scope->outer;
+    while (p->scoped_syms.len && p->scoped_syms.data[p->scoped_syms.len - 1].depth == p->scope_depth) {
+        ScopedSymbol* sym = scopedsymbols_pop(&p->scoped_syms);
+        atom_map_entry(&p->lvar_syms, sym->name)->value = sym->shadowed;
+    }
+    --p->scope_depth;
 }
 
 static void enter_func(Parser* p) {
@@ -383,10 +454,10 @@ static Type* parse_array_declarator_suffix(Parser*, Type*);
 static Type* parse_function_declarator_suffix(Parser*, Type*);
 static AstNode* parse_direct_declarator(Parser*, Type*);
 static AstNode* parse_declarator(Parser*, Type*);
-static AstNode* parse_init_declarator_list(Parser*, Type*);
+static AstNode* parse_init_declarator_list(Parser*, Type*, StorageClass);
 static AstNode* parse_declaration(Parser*);
 static AstNode* parse_function_definition(Parser*, AstNode*);
-static Type* parse_declaration_specifiers(Parser*);
+static Type* parse_declaration_specifiers(Parser*, StorageClass*);
 static AstNode* parse_init_declarator(Parser*, Type*);
 static Type* parse_struct_specifier(Parser*);
 static Type* parse_union_specifier(Parser*);
@@ -465,19 +536,13 @@ static void register_params(Parser* p, AstNode* params) {
         }
         const char* name = param->as.declarator->name;
         param->kind = AstNodeKind_param;
-        param->as.param = calloc(1, sizeof(ParamNode));
+        param->as.param = arena_alloc(&parse_arena, sizeof(ParamNode));
         param->as.param->name = name;
         param->as.param->stack_offset = stack_offset;
         add_lvar(p, name, param->ty, stack_offset);
     }
 }
 
-static void register_func(Parser* p, const char* name, Type* ty) {
-    Func* func = funcs_push_new(&p->funcs);
-    func->name = name;
-    func->ty = ty;
-}
-
 typedef enum {
     TypeSpecifierMask_void = 1 << 0,
     TypeSpecifierMask_char = 1 << 1,
@@ -656,17 +721,15 @@ static AstNode* parse_primary_expr(Parser* p) {
                 if (enum_member_idx == -1) {
                     int func_idx = find_func(p, name);
                     if (func_idx == -1) {
-                        fatal_error("%s:%d: undefined variable: %s", t->loc.filename, t->loc.line, name);
+                        fatal_error("%s:%d: undefined variable: %s", token_filename(t), token_line(t), name);
                     }
                     return ast_new_func(name, p->funcs.data[func_idx].ty);
                 }
-                int enum_idx = enum_member_idx / 1000;
-                int n = enum_member_idx % 1000;
+                int enum_idx = p->enum_members.data[enum_member_idx].enum_index;
+                int n = p->enum_members.data[enum_member_idx].member_index;
                 AstNode* e = ast_new_int(
                     p->enums->as.list->items[enum_idx].as.enum_def->members->as.list->items[n].as.enum_member->value);
-                e->ty = type_new(TypeKind_enum);
-                e->ty->ref.defs = p->enums;
-                e->ty->ref.index = enum_idx;
+                e->ty = type_new_ref(TypeKind_enum, p->enums, enum_idx);
                 return e;
             }
             return ast_new_gvar(name, p->gvars.data[gvar_idx].ty);
@@ -674,7 +737,8 @@ static AstNode* parse_primary_expr(Parser* p) {
 
         return ast_new_lvar(name, p->lvars.data[lvar_idx].stack_offset, p->lvars.data[lvar_idx].ty);
     } else {
-        fatal_error("%s:%d: expected an expression, but got '%s'", t->loc.filename, t->loc.line, token_stringify(t));
+        fatal_error("%s:%d: expected an expression, but got '%s'", token_filename(t), token_line(t),
+                    token_stringify(t));
     }
 }
 
@@ -1112,7 +1176,7 @@ static AstNode* parse_declarator_or_abstract_declarator_opt(Parser* p, Type* ty)
         next_token(p);
         if (peek_token(p)->kind == TokenKind_paren_r) {
             Token* tok = peek_token(p);
-            fatal_error("%s:%d: expected declarator, but got '%s'", tok->loc.filename, tok->loc.line,
+            fatal_error("%s:%d: expected declarator, but got '%s'", token_filename(tok), token_line(tok),
                         token_stringify(tok));
         }
         decl = parse_declarator_or_abstract_declarator_opt(p, ty);
@@ -1189,7 +1253,8 @@ static AstNode* parse_parameter_declaration(Parser* p) {
         return ast_new_declarator("...", NULL);
     }
 
-    Type* base_ty = parse_declaration_specifiers(p);
+    StorageClass storage_class;
+    Type* base_ty = parse_declaration_specifiers(p, &storage_class);
     return parse_declarator_or_abstract_declarator_opt(p, base_ty);
 }
 
@@ -1287,16 +1352,17 @@ static AstNode* parse_declarator(Parser* p, Type* ty) {
 // init-declarator-list:
 //     init-declarator
 //     init-declarator-list ',' init-declarator
-static AstNode* parse_init_declarator_list(Parser* p, Type* ty) {
+static AstNode* parse_init_declarator_list(Parser* p, Type* ty, StorageClass storage_class) {
     AstNode* list = ast_new_list(1);
     while (1) {
         AstNode* d = parse_init_declarator(p, ty);
+        d->as.declarator->storage_class = storage_class;
         ast_append(list, d);
         if (!consume_token_if(p, TokenKind_comma)) {
             break;
         }
 
-        if (ty->storage_class == StorageClass_typedef) {
+        if (storage_class == StorageClass_typedef) {
             continue;
         }
         // Immediately declare to allow following initializer to access previous variables. For example,
@@ -1316,23 +1382,73 @@ static AstNode* parse_declaration(Parser* p) {
         return parse_static_assert_declaration(p);
     }
 
-    Type* ty = parse_declaration_specifiers(p);
-    AstNode* decls = parse_init_declarator_list(p, ty);
+    StorageClass storage_class;
+    Type* ty = parse_declaration_specifiers(p, &storage_class);
+    AstNode* decls = parse_init_declarator_list(p, ty, storage_class);
     expect(p, TokenKind_semicolon);
     process_declarations(p, &decls->as.list->items[decls->as.list->len - 1]);
     return decls;
 }
 
+// Returns the number of elements initialized by the items, where embedded data counts as one element per byte.
+static int initializer_list_len(AstNode* items) {
+    int len = 0;
+    for (int i = 0; i < items->as.list->len; ++i) {
+        AstNode* item = &items->as.list->items[i];
+        if (item->kind == AstNodeKind_embedded_data) {
+            len += item->as.embedded_data->len;
+        } else {
+            ++len;
+        }
+    }
+    return len;
+}
+
+static void reject_embedded_data_in_member_initializer(AstNode* items) {
+    for (int i = 0; i < items->as.list->len; ++i) {
+        if (items->as.list->items[i].kind == AstNodeKind_embedded_data) {
+            fatal_error("#embed in struct or union initializer is not supported");
+        }
+    }
+}
+
+// Embedded data initializes one array element per byte, which is only supported for elements of scalar types.
+static void reject_embedded_data_in_aggregate_elements(AstNode* items, Type* elem_ty) {
+    if (elem_ty->kind != TypeKind_array && elem_ty->kind != TypeKind_struct && elem_ty->kind != TypeKind_union) {
+        return;
+    }
+    for (int i = 0; i < items->as.list->len; ++i) {
+        if (items->as.list->items[i].kind == AstNodeKind_embedded_data) {
+            fatal_error("#embed in initializer of array of aggregates is not supported");
+        }
+    }
+}
+
+static AstNode* local_array_element(AstNode* lhs, int index, Type* elem_ty) {
+    AstNode* idx = ast_new_binary_expr(TokenKind_star, ast_new_int(index), ast_new_int(type_sizeof(elem_ty)));
+    return ast_new_deref_expr(ast_new_binary_expr(TokenKind_plus, lhs, idx));
+}
+
 static void create_local_initializer(AstNode* list, AstNode* lhs, AstNode* init, Type* ty) {
     if (init->kind == AstNodeKind_array_initializer) {
         AstNode* items = init->as.array_initializer->list;
         if (ty->kind == TypeKind_array) {
+            reject_embedded_data_in_aggregate_elements(items, ty->base);
+            int index = 0;
             for (int i = 0; i < items->as.list->len; ++i) {
-                AstNode* idx = ast_new_binary_expr(TokenKind_star, ast_new_int(i), ast_new_int(type_sizeof(ty->base)));
-                AstNode* elem = ast_new_deref_expr(ast_new_binary_expr(TokenKind_plus, lhs, idx));
-                create_local_initializer(list, elem, &items->as.list->items[i], ty->base);
+                AstNode* item = &items->as.list->items[i];
+                if (item->kind == AstNodeKind_embedded_data) {
+                    for (size_t j = 0; j < item->as.embedded_data->len; ++j) {
+                        AstNode* elem = local_array_element(lhs, index++, ty->base);
+                        AstNode* byte = ast_new_int(item->as.embedded_data->data[j] & 0xff);
+                        create_local_initializer(list, elem, byte, ty->base);
+                    }
+                } else {
+                    create_local_initializer(list, local_array_element(lhs, index++, ty->base), item, ty->base);
+                }
             }
         } else if (ty->kind == TypeKind_struct) {
+            reject_embedded_data_in_member_initializer(items);
             AstNode* def = &ty->ref.defs->as.list->items[ty->ref.index];
             AstNode* members = def->as.struct_def->members;
             for (int i = 0; i < items->as.list->len; ++i) {
@@ -1341,6 +1457,7 @@ static void create_local_initializer(AstNode* list, AstNode* lhs, AstNode* init,
                 create_local_initializer(list, member_lhs, &items->as.list->items[i], members->as.list->items[i].ty);
             }
         } else if (ty->kind == TypeKind_union) {
+            reject_embedded_data_in_member_initializer(items);
             AstNode* def = &ty->ref.defs->as.list->items[ty->ref.index];
             AstNode* members = def->as.union_def->members;
             const char* member_name = members->as.list->items[0].as.struct_member->name;
@@ -1356,9 +1473,6 @@ static void create_local_initializer(AstNode* list, AstNode* lhs, AstNode* init,
 static void process_declarations(Parser* p, AstNode* decl) {
     const char* name = decl->as.declarator->name;
     if (decl->ty->kind == TypeKind_func) {
-        // TODO: refactor
-        decl->ty->storage_class = decl->ty->result->storage_class;
-        decl->ty->result->storage_class = StorageClass_unspecified;
         register_func(p, name, decl->ty);
         decl->kind = AstNodeKind_func_decl;
     } else {
@@ -1366,10 +1480,10 @@ static void process_declarations(Parser* p, AstNode* decl) {
             fatal_error("process_declarations: invalid type for variable");
         }
 
-        if (p->scope) {
+        if (p->scope_depth) {
             if (find_lvar_in_current_scope(p, name) != -1) {
                 // TODO: use name's location.
-                fatal_error("%s:%d: '%s' redeclared", peek_token(p)->loc.filename, peek_token(p)->loc.line, name);
+                fatal_error("%s:%d: '%s' redeclared", token_filename(peek_token(p)), token_line(peek_token(p)), name);
             }
             int stack_offset = add_lvar(p, name, decl->ty, calc_lvar_stack_offset(p, decl->ty));
 
@@ -1384,7 +1498,7 @@ static void process_declarations(Parser* p, AstNode* decl) {
                     AstNode* lhs = ast_new_lvar(name, stack_offset, decl->ty);
                     AstNode* assign = ast_new_assign_expr(TokenKind_assign, lhs, decl->as.declarator->init);
                     decl->kind = AstNodeKind_expr_stmt;
-                    decl->as.expr_stmt = calloc(1, sizeof(ExprStmtNode));
+                    decl->as.expr_stmt = arena_alloc(&parse_arena, sizeof(ExprStmtNode));
                     decl->as.expr_stmt->expr = assign;
                 }
             } else {
@@ -1395,33 +1509,27 @@ static void process_declarations(Parser* p, AstNode* decl) {
                 // TODO
                 // fatal_error("process_declarations: %s redeclared", name);
             }
-            // TODO: refactor
-            Type* base_ty = decl->ty;
-            while (base_ty->base) {
-                base_ty = base_ty->base;
-            }
-            if (base_ty != decl->ty) {
-                decl->ty->storage_class = base_ty->storage_class;
-                base_ty->storage_class = StorageClass_unspecified;
-            }
-
             // TODO: refactor
             if (decl->ty->kind == TypeKind_array && decl->ty->array_size == -1 && decl->as.declarator &&
                 decl->as.declarator->init && decl->as.declarator->init->kind == AstNodeKind_array_initializer) {
-                decl->ty->array_size = decl->as.declarator->init->as.array_initializer->list->as.list->len;
+                decl->ty = type_new_array(decl->ty->base,
+                                          initializer_list_len(decl->as.declarator->init->as.array_initializer->list));
             }
 
             GlobalVar* gvar = gvars_push_new(&p->gvars);
             gvar->name = name;
             gvar->ty = decl->ty;
+            symbols_add(&p->gvar_syms, name, p->gvars.len - 1);
 
-            if (decl->ty->storage_class == StorageClass_extern) {
+            StorageClass storage_class = decl->as.declarator->storage_class;
+            if (storage_class == StorageClass_extern) {
                 decl->kind = AstNodeKind_nop;
             } else {
                 AstNode* init_expr = decl->as.declarator ? decl->as.declarator->init : NULL;
                 decl->kind = AstNodeKind_gvar_decl;
-                decl->as.gvar_decl = calloc(1, sizeof(GvarDeclNode));
+                decl->as.gvar_decl = arena_alloc(&parse_arena, sizeof(GvarDeclNode));
                 decl->as.gvar_decl->name = name;
+                decl->as.gvar_decl->storage_class = storage_class;
                 decl->as.gvar_decl->expr = init_expr;
             }
         }
@@ -1436,12 +1544,7 @@ static AstNode* parse_function_definition(Parser* p, AstNode* decls) {
     }
 
     Type* ty = decls->as.list->items[0].ty;
-    Type* base_ty = ty->result;
-    while (base_ty->base) {
-        base_ty = base_ty->base;
-    }
-    ty->storage_class = base_ty->storage_class;
-    base_ty->storage_class = StorageClass_unspecified;
+    StorageClass storage_class = decls->as.list->items[0].as.declarator->storage_class;
     const char* name = decls->as.list->items[0].as.declarator->name;
     AstNode* params = ty->params;
 
@@ -1458,7 +1561,7 @@ static AstNode* parse_function_definition(Parser* p, AstNode* decls) {
             stack_size = 0;
         }
     }
-    return ast_new_func_def(name, ty, params, body, stack_size);
+    return ast_new_func_def(name, storage_class, ty, params, body, stack_size);
 }
 
 static void process_typedefs(Parser* p, AstNode* decls) {
@@ -1467,13 +1570,14 @@ static void process_typedefs(Parser* p, AstNode* decls) {
 
         AstNode* typedef_ = ast_new_typedef_decl(decl->as.declarator->name, decl->ty);
         ast_append(p->typedefs, typedef_);
+        symbols_add(&p->typedef_syms, typedef_->as.typedef_decl->name, p->typedefs->as.list->len - 1);
     }
 }
 
-static char* generate_anonymous_name(Parser* p) {
-    char* buf = calloc(32, sizeof(char));
+static const char* generate_anonymous_name(Parser* p) {
+    char buf[32];
     sprintf(buf, "__anonymous_%d__", p->anonymous_user_type_counter++);
-    return buf;
+    return atom_intern_string(buf);
 }
 
 // declaration-specifiers:
@@ -1550,8 +1654,8 @@ static char* generate_anonymous_name(Parser* p) {
 //
 // typedef-name:
 //     identifier
-static Type* parse_declaration_specifiers(Parser* p) {
-    StorageClass storage_class = StorageClass_unspecified;
+static Type* parse_declaration_specifiers(Parser* p, StorageClass* storage_class) {
+    *storage_class = StorageClass_unspecified;
     int type_specifiers = 0;
     Type* ty = NULL;
 
@@ -1566,130 +1670,130 @@ static Type* parse_declaration_specifiers(Parser* p) {
             unimplemented();
         } else if (tok->kind == TokenKind_keyword_extern) {
             next_token(p);
-            storage_class = StorageClass_extern;
+            *storage_class = StorageClass_extern;
         } else if (tok->kind == TokenKind_keyword_register) {
             unimplemented();
         } else if (tok->kind == TokenKind_keyword_static) {
             next_token(p);
-            storage_class = StorageClass_static;
+            *storage_class = StorageClass_static;
         } else if (tok->kind == TokenKind_keyword_thread_local) {
             unimplemented();
         } else if (tok->kind == TokenKind_keyword_typedef) {
             next_token(p);
-            storage_class = StorageClass_typedef;
+            *storage_class = StorageClass_typedef;
         }
         // type-specifier-qualifier > type-specifier
         else if (tok->kind == TokenKind_keyword_void) {
             if (type_specifiers & TypeSpecifierMask_void) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_void;
         } else if (tok->kind == TokenKind_keyword_char) {
             if (type_specifiers & TypeSpecifierMask_char) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_char;
         } else if (tok->kind == TokenKind_keyword_short) {
             if (type_specifiers & TypeSpecifierMask_short) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_short;
         } else if (tok->kind == TokenKind_keyword_int) {
             if (type_specifiers & TypeSpecifierMask_int) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_int;
         } else if (tok->kind == TokenKind_keyword_long) {
             if (type_specifiers & (TypeSpecifierMask_long + TypeSpecifierMask_long)) {
-                fatal_error("%s:%d: too looong!", tok->loc.filename, tok->loc.line);
+                fatal_error("%s:%d: too looong!", token_filename(tok), token_line(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_long;
         } else if (tok->kind == TokenKind_keyword_float) {
             if (type_specifiers & TypeSpecifierMask_float) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_float;
         } else if (tok->kind == TokenKind_keyword_double) {
             if (type_specifiers & TypeSpecifierMask_double) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_double;
         } else if (tok->kind == TokenKind_keyword_signed) {
             if (type_specifiers & TypeSpecifierMask_signed) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_signed;
         } else if (tok->kind == TokenKind_keyword_unsigned) {
             if (type_specifiers & TypeSpecifierMask_unsigned) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_unsigned;
         } else if (tok->kind == TokenKind_keyword__BitInt) {
             if (type_specifiers & TypeSpecifierMask__BitInt) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__BitInt;
         } else if (tok->kind == TokenKind_keyword_bool) {
             if (type_specifiers & TypeSpecifierMask_bool) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_bool;
         } else if (tok->kind == TokenKind_keyword__Complex) {
             if (type_specifiers & TypeSpecifierMask__Complex) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Complex;
         } else if (tok->kind == TokenKind_keyword__Decimal32) {
             if (type_specifiers & TypeSpecifierMask__Decimal32) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Decimal32;
         } else if (tok->kind == TokenKind_keyword__Decimal64) {
             if (type_specifiers & TypeSpecifierMask__Decimal64) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Decimal64;
         } else if (tok->kind == TokenKind_keyword__Decimal128) {
             if (type_specifiers & TypeSpecifierMask__Decimal128) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Decimal128;
         } else if (tok->kind == TokenKind_keyword__Atomic) {
             if (type_specifiers & TypeSpecifierMask__Atomic) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Atomic;
         } else if (tok->kind == TokenKind_keyword_struct) {
             if (type_specifiers & TypeSpecifierMask_struct) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             ty = parse_struct_specifier(p);
             type_specifiers += TypeSpecifierMask_struct;
         } else if (tok->kind == TokenKind_keyword_union) {
             if (type_specifiers & TypeSpecifierMask_union) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             ty = parse_union_specifier(p);
             type_specifiers += TypeSpecifierMask_union;
         } else if (tok->kind == TokenKind_keyword_enum) {
             if (type_specifiers & TypeSpecifierMask_enum) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             ty = parse_enum_specifier(p);
             type_specifiers += TypeSpecifierMask_enum;
@@ -1699,11 +1803,11 @@ static Type* parse_declaration_specifiers(Parser* p) {
             unimplemented();
         } else if (is_typedef_name(p, tok)) {
             if (type_specifiers & TypeSpecifierMask_typedef_name) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             int typedef_idx = find_typedef(p, tok->value.string);
-            ty = type_dup(p->typedefs->as.list->items[typedef_idx].ty);
+            ty = p->typedefs->as.list->items[typedef_idx].ty;
             type_specifiers += TypeSpecifierMask_typedef_name;
         }
         // type-specifier-qualifier > type-qualifier
@@ -1740,10 +1844,9 @@ static Type* parse_declaration_specifiers(Parser* p) {
         ty = ty_;
     }
     if (!ty) {
-        fatal_error("%s:%d: no type specifiers", tok->loc.filename, tok->loc.line);
+        fatal_error("%s:%d: no type specifiers", token_filename(tok), token_line(tok));
     }
 
-    ty->storage_class = storage_class;
     return ty;
 }
 
@@ -1762,17 +1865,17 @@ static AstNode* parse_init_declarator(Parser* p, Type* ty) {
 //     'struct' TODO attribute-specifier-sequence? identifier? '{' member-declaration-list '}'
 //     'struct' TODO attribute-specifier-sequence? identifier
 static Type* parse_struct_specifier(Parser* p) {
-    SourceLocation struct_kw_loc = current_location(p);
+    SourcePos struct_kw_pos = peek_token(p)->pos;
     next_token(p);
 
     const Token* name;
-    char* anonymous_name = NULL;
+    const char* anonymous_name = NULL;
     if (peek_token(p)->kind == TokenKind_brace_l) {
         anonymous_name = generate_anonymous_name(p);
-        Token* anonymous_token = calloc(1, sizeof(Token));
+        Token* anonymous_token = arena_alloc(&parse_arena, sizeof(Token));
         anonymous_token->kind = TokenKind_ident;
         anonymous_token->value.string = anonymous_name;
-        anonymous_token->loc = struct_kw_loc;
+        anonymous_token->pos = struct_kw_pos;
         name = anonymous_token;
     } else {
         name = parse_ident(p);
@@ -1781,41 +1884,31 @@ static Type* parse_struct_specifier(Parser* p) {
     if (!consume_token_if(p, TokenKind_brace_l)) {
         int struct_idx = find_struct(p, name->value.string);
         if (struct_idx != -1) {
-            Type* ty = type_new(TypeKind_struct);
-            ty->ref.defs = p->structs;
-            ty->ref.index = struct_idx;
+            Type* ty = type_new_ref(TypeKind_struct, p->structs, struct_idx);
             return ty;
         } else {
             // TODO
-            AstNode* new_struct = ast_new_struct_def(name->value.string);
-            ast_append(p->structs, new_struct);
-            struct_idx = p->structs->as.list->len - 1;
+            struct_idx = register_struct(p, name->value.string);
 
-            Type* ty = type_new(TypeKind_struct);
-            ty->ref.defs = p->structs;
-            ty->ref.index = struct_idx;
+            Type* ty = type_new_ref(TypeKind_struct, p->structs, struct_idx);
             return ty;
         }
     }
 
     int struct_idx = find_struct(p, name->value.string);
     if (struct_idx != -1 && p->structs->as.list->items[struct_idx].as.struct_def->members) {
-        fatal_error("%s:%d: struct %s redefined", name->loc.filename, name->loc.line, name->value.string);
+        fatal_error("%s:%d: struct %s redefined", token_filename(name), token_line(name), name->value.string);
     }
 
     if (struct_idx == -1) {
-        AstNode* new_struct = ast_new_struct_def(name->value.string);
-        ast_append(p->structs, new_struct);
-        struct_idx = p->structs->as.list->len - 1;
+        struct_idx = register_struct(p, name->value.string);
     }
 
     AstNode* members = parse_member_declaration_list(p);
     expect(p, TokenKind_brace_r);
     p->structs->as.list->items[struct_idx].as.struct_def->members = members;
 
-    Type* ty = type_new(TypeKind_struct);
-    ty->ref.defs = p->structs;
-    ty->ref.index = struct_idx;
+    Type* ty = type_new_ref(TypeKind_struct, p->structs, struct_idx);
     return ty;
 }
 
@@ -1823,17 +1916,17 @@ static Type* parse_struct_specifier(Parser* p) {
 //     'union' TODO attribute-specifier-sequence? identifier? '{' member-declaration-list '}'
 //     'union' TODO attribute-specifier-sequence? identifier
 static Type* parse_union_specifier(Parser* p) {
-    SourceLocation union_kw_loc = current_location(p);
+    SourcePos union_kw_pos = peek_token(p)->pos;
     next_token(p);
 
     const Token* name;
-    char* anonymous_name = NULL;
+    const char* anonymous_name = NULL;
     if (peek_token(p)->kind == TokenKind_brace_l) {
         anonymous_name = generate_anonymous_name(p);
-        Token* anonymous_token = calloc(1, sizeof(Token));
+        Token* anonymous_token = arena_alloc(&parse_arena, sizeof(Token));
         anonymous_token->kind = TokenKind_ident;
         anonymous_token->value.string = anonymous_name;
-        anonymous_token->loc = union_kw_loc;
+        anonymous_token->pos = union_kw_pos;
         name = anonymous_token;
     } else {
         name = parse_ident(p);
@@ -1842,41 +1935,31 @@ static Type* parse_union_specifier(Parser* p) {
     if (!consume_token_if(p, TokenKind_brace_l)) {
         int union_idx = find_union(p, name->value.string);
         if (union_idx != -1) {
-            Type* ty = type_new(TypeKind_union);
-            ty->ref.defs = p->unions;
-            ty->ref.index = union_idx;
+            Type* ty = type_new_ref(TypeKind_union, p->unions, union_idx);
             return ty;
         } else {
             // TODO
-            AstNode* new_union = ast_new_union_def(name->value.string);
-            ast_append(p->unions, new_union);
-            union_idx = p->unions->as.list->len - 1;
+            union_idx = register_union(p, name->value.string);
 
-            Type* ty = type_new(TypeKind_union);
-            ty->ref.defs = p->unions;
-            ty->ref.index = union_idx;
+            Type* ty = type_new_ref(TypeKind_union, p->unions, union_idx);
             return ty;
         }
     }
 
     int union_idx = find_union(p, name->value.string);
     if (union_idx != -1 && p->unions->as.list->items[union_idx].as.union_def->members) {
-        fatal_error("%s:%d: union %s redefined", name->loc.filename, name->loc.line, name->value.string);
+        fatal_error("%s:%d: union %s redefined", token_filename(name), token_line(name), name->value.string);
     }
 
     if (union_idx == -1) {
-        AstNode* new_union = ast_new_union_def(name->value.string);
-        ast_append(p->unions, new_union);
-        union_idx = p->unions->as.list->len - 1;
+        union_idx = register_union(p, name->value.string);
     }
 
     AstNode* members = parse_member_declaration_list(p);
     expect(p, TokenKind_brace_r);
     p->unions->as.list->items[union_idx].as.union_def->members = members;
 
-    Type* ty = type_new(TypeKind_union);
-    ty->ref.defs = p->unions;
-    ty->ref.index = union_idx;
+    Type* ty = type_new_ref(TypeKind_union, p->unions, union_idx);
     return ty;
 }
 
@@ -1900,11 +1983,11 @@ static AstNode* parse_member_declaration(Parser* p) {
     Type* base_ty = parse_specifier_qualifier_list(p);
 
     if (consume_token_if(p, TokenKind_semicolon)) {
-        char* name = generate_anonymous_name(p);
+        const char* name = generate_anonymous_name(p);
         AstNode* decls = ast_new_list(1);
         AstNode* member = ast_new(AstNodeKind_struct_member);
         member->ty = base_ty;
-        member->as.struct_member = calloc(1, sizeof(StructMemberNode));
+        member->as.struct_member = arena_alloc(&parse_arena, sizeof(StructMemberNode));
         member->as.struct_member->name = name;
         ast_append(decls, member);
         return decls;
@@ -1926,115 +2009,115 @@ static Type* parse_specifier_qualifier_list(Parser* p) {
         // type-specifier-qualifier > type-specifier
         if (tok->kind == TokenKind_keyword_void) {
             if (type_specifiers & TypeSpecifierMask_void) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_void;
         } else if (tok->kind == TokenKind_keyword_char) {
             if (type_specifiers & TypeSpecifierMask_char) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_char;
         } else if (tok->kind == TokenKind_keyword_short) {
             if (type_specifiers & TypeSpecifierMask_short) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_short;
         } else if (tok->kind == TokenKind_keyword_int) {
             if (type_specifiers & TypeSpecifierMask_int) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_int;
         } else if (tok->kind == TokenKind_keyword_long) {
             if (type_specifiers & (TypeSpecifierMask_long + TypeSpecifierMask_long)) {
-                fatal_error("%s:%d: too looong!", tok->loc.filename, tok->loc.line);
+                fatal_error("%s:%d: too looong!", token_filename(tok), token_line(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_long;
         } else if (tok->kind == TokenKind_keyword_float) {
             if (type_specifiers & TypeSpecifierMask_float) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_float;
         } else if (tok->kind == TokenKind_keyword_double) {
             if (type_specifiers & TypeSpecifierMask_double) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_double;
         } else if (tok->kind == TokenKind_keyword_signed) {
             if (type_specifiers & TypeSpecifierMask_signed) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_signed;
         } else if (tok->kind == TokenKind_keyword_unsigned) {
             if (type_specifiers & TypeSpecifierMask_unsigned) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_unsigned;
         } else if (tok->kind == TokenKind_keyword__BitInt) {
             if (type_specifiers & TypeSpecifierMask__BitInt) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__BitInt;
         } else if (tok->kind == TokenKind_keyword_bool) {
             if (type_specifiers & TypeSpecifierMask_bool) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask_bool;
         } else if (tok->kind == TokenKind_keyword__Complex) {
             if (type_specifiers & TypeSpecifierMask__Complex) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Complex;
         } else if (tok->kind == TokenKind_keyword__Decimal32) {
             if (type_specifiers & TypeSpecifierMask__Decimal32) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Decimal32;
         } else if (tok->kind == TokenKind_keyword__Decimal64) {
             if (type_specifiers & TypeSpecifierMask__Decimal64) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Decimal64;
         } else if (tok->kind == TokenKind_keyword__Decimal128) {
             if (type_specifiers & TypeSpecifierMask__Decimal128) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Decimal128;
         } else if (tok->kind == TokenKind_keyword__Atomic) {
             if (type_specifiers & TypeSpecifierMask__Atomic) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             type_specifiers += TypeSpecifierMask__Atomic;
         } else if (tok->kind == TokenKind_keyword_struct) {
             if (type_specifiers & TypeSpecifierMask_struct) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             ty = parse_struct_specifier(p);
             type_specifiers += TypeSpecifierMask_struct;
         } else if (tok->kind == TokenKind_keyword_union) {
             if (type_specifiers & TypeSpecifierMask_union) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             ty = parse_union_specifier(p);
             type_specifiers += TypeSpecifierMask_union;
         } else if (tok->kind == TokenKind_keyword_enum) {
             if (type_specifiers & TypeSpecifierMask_enum) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             ty = parse_enum_specifier(p);
             type_specifiers += TypeSpecifierMask_enum;
@@ -2044,11 +2127,11 @@ static Type* parse_specifier_qualifier_list(Parser* p) {
             unimplemented();
         } else if (is_typedef_name(p, tok)) {
             if (type_specifiers & TypeSpecifierMask_typedef_name) {
-                fatal_error("%s:%d: duplicate '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+                fatal_error("%s:%d: duplicate '%s'", token_filename(tok), token_line(tok), token_stringify(tok));
             }
             next_token(p);
             int typedef_idx = find_typedef(p, tok->value.string);
-            ty = type_dup(p->typedefs->as.list->items[typedef_idx].ty);
+            ty = p->typedefs->as.list->items[typedef_idx].ty;
             type_specifiers += TypeSpecifierMask_typedef_name;
         }
         // type-specifier-qualifier > type-qualifier
@@ -2076,7 +2159,6 @@ static Type* parse_specifier_qualifier_list(Parser* p) {
         ty = ty_;
     }
 
-    ty->storage_class = StorageClass_unspecified;
     return ty;
 }
 
@@ -2103,7 +2185,7 @@ static AstNode* parse_member_declarator(Parser* p, Type* base_ty) {
 
     const char* name = decl->as.declarator->name;
     decl->kind = AstNodeKind_struct_member;
-    decl->as.struct_member = calloc(1, sizeof(StructMemberNode));
+    decl->as.struct_member = arena_alloc(&parse_arena, sizeof(StructMemberNode));
     decl->as.struct_member->name = name;
 
     if (consume_token_if(p, TokenKind_colon)) {
@@ -2133,17 +2215,17 @@ static AstNode* parse_member_declarator(Parser* p, Type* base_ty) {
 //     'enum' TODO attribute-specifier-sequence? identifier? TODO enum-type-specifier? '{' enumerator-list ','? '}'
 //     'enum' identifier TODO enum-type-specifier?
 static Type* parse_enum_specifier(Parser* p) {
-    SourceLocation enum_kw_loc = current_location(p);
+    SourcePos enum_kw_pos = peek_token(p)->pos;
     next_token(p);
 
     const Token* name;
-    char* anonymous_name = NULL;
+    const char* anonymous_name = NULL;
     if (peek_token(p)->kind == TokenKind_brace_l) {
         anonymous_name = generate_anonymous_name(p);
-        Token* anonymous_token = calloc(1, sizeof(Token));
+        Token* anonymous_token = arena_alloc(&parse_arena, sizeof(Token));
         anonymous_token->kind = TokenKind_ident;
         anonymous_token->value.string = anonymous_name;
-        anonymous_token->loc = enum_kw_loc;
+        anonymous_token->pos = enum_kw_pos;
         name = anonymous_token;
     } else {
         name = parse_ident(p);
@@ -2152,40 +2234,30 @@ static Type* parse_enum_specifier(Parser* p) {
     if (!consume_token_if(p, TokenKind_brace_l)) {
         int enum_idx = find_enum(p, name->value.string);
         if (enum_idx != -1) {
-            Type* ty = type_new(TypeKind_enum);
-            ty->ref.defs = p->enums;
-            ty->ref.index = enum_idx;
+            Type* ty = type_new_ref(TypeKind_enum, p->enums, enum_idx);
             return ty;
         } else {
             // TODO
-            AstNode* new_enum = ast_new_enum_def(name->value.string);
-            ast_append(p->enums, new_enum);
-            enum_idx = p->enums->as.list->len - 1;
+            enum_idx = register_enum(p, name->value.string);
 
-            Type* ty = type_new(TypeKind_enum);
-            ty->ref.defs = p->enums;
-            ty->ref.index = enum_idx;
+            Type* ty = type_new_ref(TypeKind_enum, p->enums, enum_idx);
             return ty;
         }
     }
 
     int enum_idx = find_enum(p, name->value.string);
     if (enum_idx != -1 && p->enums->as.list->items[enum_idx].as.enum_def->members) {
-        fatal_error("%s:%d: enum %s redefined", name->loc.filename, name->loc.line, name->value.string);
+        fatal_error("%s:%d: enum %s redefined", token_filename(name), token_line(name), name->value.string);
     }
 
     if (enum_idx == -1) {
-        AstNode* new_enum = ast_new_enum_def(name->value.string);
-        ast_append(p->enums, new_enum);
-        enum_idx = p->enums->as.list->len - 1;
+        enum_idx = register_enum(p, name->value.string);
     }
 
     parse_enum_members(p, enum_idx);
     expect(p, TokenKind_brace_r);
 
-    Type* ty = type_new(TypeKind_enum);
-    ty->ref.defs = p->enums;
-    ty->ref.index = enum_idx;
+    Type* ty = type_new_ref(TypeKind_enum, p->enums, enum_idx);
     return ty;
 }
 
@@ -2204,6 +2276,10 @@ static void parse_enum_members(Parser* p, int enum_idx) {
         next_value = member->as.enum_member->value + 1;
 
         ast_append(list, member);
+        EnumMemberRef* ref = enummemberrefs_push_new(&p->enum_members);
+        ref->enum_index = enum_idx;
+        ref->member_index = list->as.list->len - 1;
+        symbols_add(&p->enum_member_syms, member->as.enum_member->name, p->enum_members.len - 1);
 
         if (!consume_token_if(p, TokenKind_comma)) {
             break;
@@ -2245,12 +2321,20 @@ static Type* parse_abstract_declarator_opt(Parser* p, Type* ty) {
 
 // braced-initializer:
 //     '{' { designation? initializer |? ',' }* '}'
+//
+// An #embed directive in the list arrives as a single embedded-data token.
 static AstNode* parse_braced_initializer(Parser* p) {
     AstNode* inits = ast_new_list(4);
     expect(p, TokenKind_brace_l);
     while (peek_token(p)->kind != TokenKind_brace_r) {
         // TODO: support designation
-        AstNode* init = parse_initializer(p);
+        AstNode* init;
+        if (peek_token(p)->kind == TokenKind_embedded_data) {
+            const EmbeddedData* embedded = next_token(p)->value.embedded_data;
+            init = ast_new_embedded_data(embedded->data, embedded->len);
+        } else {
+            init = parse_initializer(p);
+        }
         ast_append(inits, init);
         if (!consume_token_if(p, TokenKind_comma)) {
             break;
@@ -2447,7 +2531,7 @@ static AstNode* parse_label(Parser* p) {
     AstNode* node;
     if (t->kind == TokenKind_keyword_case) {
         if (!p->current_switch) {
-            fatal_error("%s:%d: 'case' label not within a switch statement", t->loc.filename, t->loc.line);
+            fatal_error("%s:%d: 'case' label not within a switch statement", token_filename(t), token_line(t));
         }
         expect(p, TokenKind_keyword_case);
         AstNode* value = parse_constant_expr(p);
@@ -2455,7 +2539,7 @@ static AstNode* parse_label(Parser* p) {
         node = ast_new_case_label(eval(value), ast_new_nop());
     } else if (t->kind == TokenKind_keyword_default) {
         if (!p->current_switch) {
-            fatal_error("%s:%d: 'default' label not within a switch statement", t->loc.filename, t->loc.line);
+            fatal_error("%s:%d: 'default' label not within a switch statement", token_filename(t), token_line(t));
         }
         expect(p, TokenKind_keyword_default);
         expect(p, TokenKind_colon);
@@ -2761,20 +2845,21 @@ static AstNode* parse_external_declaration(Parser* p) {
         return parse_static_assert_declaration(p);
     }
 
-    Type* ty = parse_declaration_specifiers(p);
+    StorageClass storage_class;
+    Type* ty = parse_declaration_specifiers(p, &storage_class);
     if (consume_token_if(p, TokenKind_semicolon)) {
         // Type declaration.
         return NULL;
     }
 
-    AstNode* decls = parse_init_declarator_list(p, ty);
+    AstNode* decls = parse_init_declarator_list(p, ty, storage_class);
 
     if (peek_token(p)->kind == TokenKind_brace_l) {
         return parse_function_definition(p, decls);
     }
 
     expect(p, TokenKind_semicolon);
-    if (ty->storage_class == StorageClass_typedef) {
+    if (storage_class == StorageClass_typedef) {
         process_typedefs(p, decls);
         return NULL;
     } else {
@@ -2804,7 +2889,7 @@ Program* parse(TokenArray* tokens) {
             }
         }
     }
-    Program* prog = calloc(1, sizeof(Program));
+    Program* prog = arena_alloc(&parse_arena, sizeof(Program));
     prog->funcs = funcs;
     prog->vars = vars;
     prog->str_literals = p->str_literals.data;
@@ -2893,15 +2978,8 @@ static int eval(AstNode* e) {
     }
 }
 
-bool pp_eval_constant_expr(TokenArray* pp_tokens) {
-    TokenArray* tokens = convert_pp_tokens_to_tokens(pp_tokens);
-    Parser* p = parser_new(tokens);
-    AstNode* e = parse_constant_expr(p);
-    return eval(e) != 0;
-}
-
 static InitData* initdata_new() {
-    InitData* init_data = calloc(1, sizeof(InitData));
+    InitData* init_data = arena_alloc(&parse_arena, sizeof(InitData));
     init_data->len = 0;
     init_data->capacity = 1;
     init_data->blocks = calloc(init_data->capacity, sizeof(InitDataBlock));
@@ -2932,7 +3010,7 @@ static void initdata_append_addr(InitData* buf, const char* label) {
 static void initdata_append_zeros(InitData* buf, size_t len) {
     if (len == 0)
         return;
-    char* data = calloc(len, sizeof(char));
+    char* data = arena_alloc(&parse_arena, len);
     InitDataBlock* block = initdata_push_new(buf);
     block->kind = InitDataBlockKind_bytes;
     block->as.bytes.len = len;
@@ -2940,7 +3018,7 @@ static void initdata_append_zeros(InitData* buf, size_t len) {
 }
 
 static void initdata_append_bytes(InitData* buf, const char* data, size_t len) {
-    char* copy = calloc(len, sizeof(char));
+    char* copy = arena_alloc(&parse_arena, len);
     memcpy(copy, data, len);
     InitDataBlock* block = initdata_push_new(buf);
     block->kind = InitDataBlockKind_bytes;
@@ -2948,14 +3026,23 @@ static void initdata_append_bytes(InitData* buf, const char* data, size_t len) {
     block->as.bytes.buf = copy;
 }
 
+static void initdata_append_bytes_ref(InitData* buf, const char* data, size_t len) {
+    InitDataBlock* block = initdata_push_new(buf);
+    block->kind = InitDataBlockKind_bytes;
+    block->as.bytes.len = len;
+    block->as.bytes.buf = data;
+}
+
 static void do_eval_init_expr(InitData* buf, AstNode* expr, Type* ty) {
     if (expr->kind == AstNodeKind_array_initializer) {
         AstNode* list = expr->as.array_initializer->list;
         if (ty->kind == TypeKind_array) {
+            reject_embedded_data_in_aggregate_elements(list, ty->base);
             for (int i = 0; i < list->as.list->len; ++i) {
                 do_eval_init_expr(buf, &list->as.list->items[i], ty->base);
             }
         } else if (ty->kind == TypeKind_struct) {
+            reject_embedded_data_in_member_initializer(list);
             AstNode* def = &ty->ref.defs->as.list->items[ty->ref.index];
             AstNode* members = def->as.struct_def->members;
             int offset = 0;
@@ -2971,6 +3058,7 @@ static void do_eval_init_expr(InitData* buf, AstNode* expr, Type* ty) {
             int total = type_sizeof(ty);
             initdata_append_zeros(buf, total - offset); // padding
         } else if (ty->kind == TypeKind_union) {
+            reject_embedded_data_in_member_initializer(list);
             AstNode* def = &ty->ref.defs->as.list->items[ty->ref.index];
             AstNode* members = def->as.union_def->members;
             AstNode* member = &members->as.list->items[0];
@@ -2981,11 +3069,26 @@ static void do_eval_init_expr(InitData* buf, AstNode* expr, Type* ty) {
         } else {
             unimplemented();
         }
+    } else if (expr->kind == AstNodeKind_embedded_data) {
+        const char* data = expr->as.embedded_data->data;
+        size_t len = expr->as.embedded_data->len;
+        int size = type_sizeof(ty);
+        if (size == 1) {
+            // The bytes are emitted as they are, without copying the resource.
+            initdata_append_bytes_ref(buf, data, len);
+        } else {
+            // Each element holds the value of one byte, stored little-endian.
+            char* elements = arena_calloc(&parse_arena, len, size);
+            for (size_t i = 0; i < len; ++i) {
+                elements[i * size] = data[i];
+            }
+            initdata_append_bytes_ref(buf, elements, len * size);
+        }
     } else if (ty->kind == TypeKind_ptr) {
         if (expr->kind == AstNodeKind_str_expr) {
             char label[32];
             sprintf(label, ".Lstr__%d", expr->as.str_expr->idx);
-            initdata_append_addr(buf, strdup(label));
+            initdata_append_addr(buf, arena_strdup(&parse_arena, label));
         } else if (expr->kind == AstNodeKind_ref_expr) {
             if (expr->as.ref_expr->operand->kind != AstNodeKind_gvar) {
                 unimplemented();
@@ -6,7 +6,6 @@
 #include "preprocess.h"
 
 Program* parse(TokenArray* tokens);
-bool pp_eval_constant_expr(TokenArray* pp_tokens);
 
 typedef enum {
     InitDataBlockKind_addr,
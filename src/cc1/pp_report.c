@@ -0,0 +1,410 @@
+#include "pp_report.h"
+#include <time.h>
+#include "../lib/json.h"
+#include "atom.h"
+#include "io.h"
+
+// Number of macros in each of the two hot lists, and of include chains.
+#define PP_REPORT_TOP_MACROS 10
+#define PP_REPORT_TOP_CHAINS 5
+
+typedef struct {
+    // The name the file was first seen by.
+    const char* filename;
+    // Times the file was preprocessed, and times an #include of it was skipped because of its guard.
+    int include_count;
+    int guarded_count;
+    // Time spent in the file, with and without the files it included.
+    long total_ns;
+    long self_ns;
+    int output_tokens;
+    int skipped_lines;
+    // The longest include chain that reached the file, as indices of files from the main file on.
+    IntArray deepest_chain;
+} PpReportFile;
+
+typedef struct {
+    size_t len;
+    size_t capacity;
+    PpReportFile* data;
+} PpReportFileArray;
+
+typedef struct {
+    const char* name;
+    int expansions;
+    long expanded_tokens;
+} PpReportMacro;
+
+// Indexed by the macro's index in the macro table.
+typedef struct {
+    size_t len;
+    size_t capacity;
+    PpReportMacro* data;
+} PpReportMacroArray;
+
+// A file being preprocessed.
+typedef struct {
+    int file_idx;
+    long start_ns;
+    // Time spent in the files it included so far.
+    long children_ns;
+} PpReportFrame;
+
+typedef struct {
+    PpReportFileArray files;
+    // Index in `files` by atom ID of the canonical path, plus one; 0 if the file has not been seen.
+    IntArray file_indices;
+    PpReportMacroArray macros;
+    // The files being preprocessed, from the main file on. The preprocessor limits how deep includes nest.
+    PpReportFrame* stack;
+    int stack_capacity;
+    int depth;
+} PpReport;
+
+static PpReport* report;
+
+static long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+void pp_report_enable() {
+    report = calloc(1, sizeof(PpReport));
+    report->files.capacity = 16;
+    report->files.data = calloc(report->files.capacity, sizeof(PpReportFile));
+    ints_init(&report->file_indices);
+    report->macros.capacity = 64;
+    report->macros.data = calloc(report->macros.capacity, sizeof(PpReportMacro));
+}
+
+// A file reached by several names, such as "a.h" and "./a.h", is one entry, shown under the first name.
+static int find_or_add_file(const char* filename) {
+    int id = atom_id(infile_canonical_path(filename));
+    IntArray* indices = &report->file_indices;
+    if (indices->len <= (size_t)id) {
+        // ints_reserve() clears everything past the old length.
+        ints_reserve(indices, id + 1);
+        indices->len = id + 1;
+    }
+    if (indices->data[id] != 0) {
+        return indices->data[id] - 1;
+    }
+
+    PpReportFileArray* files = &report->files;
+    if (files->len == files->capacity) {
+        files->capacity *= 2;
+        files->data = realloc(files->data, files->capacity * sizeof(PpReportFile));
+    }
+    PpReportFile* file = &files->data[files->len];
+    memset(file, 0, sizeof(PpReportFile));
+    file->filename = filename;
+    ints_init(&file->deepest_chain);
+    indices->data[id] = ++files->len;
+    return files->len - 1;
+}
+
+void pp_report_enter_file(const char* filename) {
+    if (!report) {
+        return;
+    }
+    if (report->depth == report->stack_capacity) {
+        report->stack_capacity = report->stack_capacity == 0 ? 16 : report->stack_capacity * 2;
+        report->stack = realloc(report->stack, report->stack_capacity * sizeof(PpReportFrame));
+    }
+    int file_idx = find_or_add_file(filename);
+    PpReportFile* file = &report->files.data[file_idx];
+    ++file->include_count;
+
+    PpReportFrame* frame = &report->stack[report->depth++];
+    frame->file_idx = file_idx;
+    frame->children_ns = 0;
+    if ((size_t)report->depth > file->deepest_chain.len) {
+        file->deepest_chain.len = 0;
+        for (int i = 0; i < report->depth; ++i) {
+            ints_push(&file->deepest_chain, report->stack[i].file_idx);
+        }
+    }
+    // Last, so that the bookkeeping above is not counted.
+    frame->start_ns = now_ns();
+}
+
+void pp_report_leave_file() {
+    if (!report) {
+        return;
+    }
+    PpReportFrame* frame = &report->stack[--report->depth];
+    long elapsed = now_ns() - frame->start_ns;
+    PpReportFile* file = &report->files.data[frame->file_idx];
+    file->total_ns += elapsed;
+    file->self_ns += elapsed - frame->children_ns;
+    if (report->depth > 0) {
+        report->stack[report->depth - 1].children_ns += elapsed;
+    }
+}
+
+void pp_report_guarded_include(const char* filename) {
+    if (!report) {
+        return;
+    }
+    ++report->files.data[find_or_add_file(filename)].guarded_count;
+}
+
+void pp_report_skipped_group(SourcePos start, SourcePos end) {
+    if (!report || report->depth == 0) {
+        return;
+    }
+    int lines = source_pos_decode(end).line - source_pos_decode(start).line;
+    report->files.data[report->stack[report->depth - 1].file_idx].skipped_lines += lines;
+}
+
+void pp_report_macro_expansion(int macro_idx, const char* name, int tokens) {
+    if (!report) {
+        return;
+    }
+    PpReportMacroArray* macros = &report->macros;
+    if (macros->len <= (size_t)macro_idx) {
+        if (macros->capacity <= (size_t)macro_idx) {
+            size_t old_capacity = macros->capacity;
+            while (macros->capacity <= (size_t)macro_idx) {
+                macros->capacity *= 2;
+            }
+            macros->data = realloc(macros->data, macros->capacity * sizeof(PpReportMacro));
+            memset(macros->data + old_capacity, 0, (macros->capacity - old_capacity) * sizeof(PpReportMacro));
+        }
+        macros->len = macro_idx + 1;
+    }
+    PpReportMacro* macro = &macros->data[macro_idx];
+    // A macro table entry is reused when its macro is redefined, so the name is the latest one.
+    macro->name = name;
+    ++macro->expansions;
+    macro->expanded_tokens += tokens;
+}
+
+void pp_report_count_output_tokens(TokenArray* pp_tokens) {
+    if (!report) {
+        return;
+    }
+    const char* last_filename = NULL;
+    int last_file_idx = -1;
+    for (size_t i = 0; i < pp_tokens->len; ++i) {
+        Token* tok = &pp_tokens->data[i];
+        if (tok->kind == TokenKind_removed || tok->kind == TokenKind_eof || tok->pos == 0) {
+            continue;
+        }
+        const char* filename = token_filename(tok);
+        if (filename != last_filename) {
+            last_filename = filename;
+            last_file_idx = find_or_add_file(filename);
+        }
+        ++report->files.data[last_file_idx].output_tokens;
+    }
+}
+
+// Fills `order` with the indices of the `count` largest of the `len` keys, largest first, and returns how many it
+// filled. Of equal keys, the one with the lower index comes first.
+static int top_indices(const long* keys, int len, int count, int* order) {
+    int n = 0;
+    for (int i = 0; i < len; ++i) {
+        if (n == count && keys[order[n - 1]] >= keys[i]) {
+            continue;
+        }
+        int j = n < count ? n++ : n - 1;
+        while (j > 0 && keys[order[j - 1]] < keys[i]) {
+            order[j] = order[j - 1];
+            --j;
+        }
+        order[j] = i;
+    }
+    return n;
+}
+
+static int ns_to_us(long ns) {
+    return ns / 1000;
+}
+
+static void write_ms(FILE* out, long ns) {
+    long us = ns / 1000;
+    fprintf(out, "%7ld.%03ld", us / 1000, us % 1000);
+}
+
+static void build_macros_json(JsonBuilder* b, int* order, int n) {
+    jsonbuilder_array_start(b);
+    for (int i = 0; i < n; ++i) {
+        PpReportMacro* macro = &report->macros.data[order[i]];
+        jsonbuilder_array_element_start(b);
+        jsonbuilder_object_start(b);
+        jsonbuilder_object_member_start(b, "name");
+        jsonbuilder_string(b, macro->name);
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_member_start(b, "expansions");
+        jsonbuilder_integer(b, macro->expansions);
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_member_start(b, "expanded_tokens");
+        jsonbuilder_integer(b, macro->expanded_tokens);
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_end(b);
+        jsonbuilder_array_element_end(b);
+    }
+    jsonbuilder_array_end(b);
+}
+
+static void write_json(FILE* out, int* file_order, int* macro_order_by_count, int macro_count_n,
+                       int* macro_order_by_tokens, int macro_tokens_n, int* chain_order, int chain_n) {
+    JsonBuilder* b = jsonbuilder_new();
+    jsonbuilder_object_start(b);
+
+    jsonbuilder_object_member_start(b, "files");
+    jsonbuilder_array_start(b);
+    for (size_t i = 0; i < report->files.len; ++i) {
+        PpReportFile* file = &report->files.data[file_order[i]];
+        jsonbuilder_array_element_start(b);
+        jsonbuilder_object_start(b);
+        jsonbuilder_object_member_start(b, "file");
+        jsonbuilder_string(b, file->filename);
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_member_start(b, "includes");
+        jsonbuilder_integer(b, file->include_count);
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_member_start(b, "guarded_includes");
+        jsonbuilder_integer(b, file->guarded_count);
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_member_start(b, "total_us");
+        jsonbuilder_integer(b, ns_to_us(file->total_ns));
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_member_start(b, "self_us");
+        jsonbuilder_integer(b, ns_to_us(file->self_ns));
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_member_start(b, "output_tokens");
+        jsonbuilder_integer(b, file->output_tokens);
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_member_start(b, "skipped_lines");
+        jsonbuilder_integer(b, file->skipped_lines);
+        jsonbuilder_object_member_end(b);
+        jsonbuilder_object_end(b);
+        jsonbuilder_array_element_end(b);
+    }
+    jsonbuilder_array_end(b);
+    jsonbuilder_object_member_end(b);
+
+    jsonbuilder_object_member_start(b, "macros_by_expansions");
+    build_macros_json(b, macro_order_by_count, macro_count_n);
+    jsonbuilder_object_member_end(b);
+    jsonbuilder_object_member_start(b, "macros_by_expanded_tokens");
+    build_macros_json(b, macro_order_by_tokens, macro_tokens_n);
+    jsonbuilder_object_member_end(b);
+
+    jsonbuilder_object_member_start(b, "include_chains");
+    jsonbuilder_array_start(b);
+    for (int i = 0; i < chain_n; ++i) {
+        IntArray* chain = &report->files.data[chain_order[i]].deepest_chain;
+        jsonbuilder_array_element_start(b);
+        jsonbuilder_array_start(b);
+        for (size_t j = 0; j < chain->len; ++j) {
+            jsonbuilder_array_element_start(b);
+            jsonbuilder_string(b, report->files.data[chain->data[j]].filename);
+            jsonbuilder_array_element_end(b);
+        }
+        jsonbuilder_array_end(b);
+        jsonbuilder_array_element_end(b);
+    }
+    jsonbuilder_array_end(b);
+    jsonbuilder_object_member_end(b);
+
+    jsonbuilder_object_end(b);
+    fprintf(out, "%s\n", jsonbuilder_get_output(b));
+}
+
+static void write_macros_text(FILE* out, const char* title, int* order, int n) {
+    fprintf(out, "\n%s:\n", title);
+    fprintf(out, "  expansions      tokens  macro\n");
+    for (int i = 0; i < n; ++i) {
+        PpReportMacro* macro = &report->macros.data[order[i]];
+        fprintf(out, "  %10d  %10ld  %s\n", macro->expansions, macro->expanded_tokens, macro->name);
+    }
+}
+
+static void write_text(FILE* out, int* file_order, int* macro_order_by_count, int macro_count_n,
+                       int* macro_order_by_tokens, int macro_tokens_n, int* chain_order, int chain_n) {
+    fprintf(out, "files by total time:\n");
+    fprintf(out, "     total ms      self ms  includes   guarded      tokens  skipped lines  file\n");
+    for (size_t i = 0; i < report->files.len; ++i) {
+        PpReportFile* file = &report->files.data[file_order[i]];
+        fprintf(out, "  ");
+        write_ms(out, file->total_ns);
+        fprintf(out, "  ");
+        write_ms(out, file->self_ns);
+        fprintf(out, "  %8d  %8d  %10d  %13d  %s\n", file->include_count, file->guarded_count, file->output_tokens,
+                file->skipped_lines, file->filename);
+    }
+
+    write_macros_text(out, "macros by expansions", macro_order_by_count, macro_count_n);
+    write_macros_text(out, "macros by expanded tokens", macro_order_by_tokens, macro_tokens_n);
+
+    fprintf(out, "\ndeepest include chains:\n");
+    for (int i = 0; i < chain_n; ++i) {
+        IntArray* chain = &report->files.data[chain_order[i]].deepest_chain;
+        fprintf(out, "  %d:", (int)chain->len);
+        for (size_t j = 0; j < chain->len; ++j) {
+            fprintf(out, "%s %s", j == 0 ? "" : " ->", report->files.data[chain->data[j]].filename);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void pp_report_write(FILE* out, bool json) {
+    if (!report) {
+        return;
+    }
+    int file_count = report->files.len;
+    int macro_count = report->macros.len;
+    long* keys = calloc(file_count > macro_count ? file_count : macro_count, sizeof(long));
+
+    for (int i = 0; i < file_count; ++i) {
+        keys[i] = report->files.data[i].total_ns;
+    }
+    int* file_order = calloc(file_count, sizeof(int));
+    top_indices(keys, file_count, file_count, file_order);
+
+    // Only the last file of a chain is listed, so that a chain does not show up again as the start of a longer one.
+    for (int i = 0; i < file_count; ++i) {
+        keys[i] = report->files.data[i].deepest_chain.len;
+    }
+    for (int i = 0; i < file_count; ++i) {
+        IntArray* chain = &report->files.data[i].deepest_chain;
+        for (size_t j = 0; j + 1 < chain->len; ++j) {
+            keys[chain->data[j]] = 0;
+        }
+    }
+    int* chain_order = calloc(PP_REPORT_TOP_CHAINS, sizeof(int));
+    int chain_n = top_indices(keys, file_count, PP_REPORT_TOP_CHAINS, chain_order);
+    while (chain_n > 0 && keys[chain_order[chain_n - 1]] == 0) {
+        --chain_n;
+    }
+
+    // Entries of macros that were never expanded have no name and count 0.
+    for (int i = 0; i < macro_count; ++i) {
+        keys[i] = report->macros.data[i].expansions;
+    }
+    int* macro_order_by_count = calloc(PP_REPORT_TOP_MACROS, sizeof(int));
+    int macro_count_n = top_indices(keys, macro_count, PP_REPORT_TOP_MACROS, macro_order_by_count);
+    while (macro_count_n > 0 && keys[macro_order_by_count[macro_count_n - 1]] == 0) {
+        --macro_count_n;
+    }
+    for (int i = 0; i < macro_count; ++i) {
+        keys[i] = report->macros.data[i].expansions == 0 ? -1 : report->macros.data[i].expanded_tokens;
+    }
+    int* macro_order_by_tokens = calloc(PP_REPORT_TOP_MACROS, sizeof(int));
+    int macro_tokens_n = top_indices(keys, macro_count, PP_REPORT_TOP_MACROS, macro_order_by_tokens);
+    while (macro_tokens_n > 0 && keys[macro_order_by_tokens[macro_tokens_n - 1]] < 0) {
+        --macro_tokens_n;
+    }
+
+    if (json) {
+        write_json(out, file_order, macro_order_by_count, macro_count_n, macro_order_by_tokens, macro_tokens_n,
+                   chain_order, chain_n);
+    } else {
+        write_text(out, file_order, macro_order_by_count, macro_count_n, macro_order_by_tokens, macro_tokens_n,
+                   chain_order, chain_n);
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef DUCC_PP_REPORT_H
+#define DUCC_PP_REPORT_H
+
+#include "../lib/common.h"
+#include "token.h"
+
+// --pp-report: where the preprocessor's time goes. For each file, how many times it was included, the time spent in it,
+// the output tokens that came from it and the lines its conditionals skipped; the macros that were expanded most; and
+// the deepest include chains. Nothing is recorded unless pp_report_enable() is called before preprocessing, and the
+// other functions do nothing then.
+void pp_report_enable();
+
+// Called around the preprocessing of each file, including the main one. Files are told apart by canonical path.
+void pp_report_enter_file(const char* filename);
+void pp_report_leave_file();
+// An #include of the file was skipped because of its include guard or #pragma once.
+void pp_report_guarded_include(const char* filename);
+// The lines of a conditional group from `start` up to the directive at `end` were skipped in the current file.
+void pp_report_skipped_group(SourcePos start, SourcePos end);
+// The macro with index `macro_idx` in the macro table was expanded into `tokens` tokens, after rescanning.
+void pp_report_macro_expansion(int macro_idx, const char* name, int tokens);
+// Attributes the tokens of the preprocessor's output to the files they came from. Tokens made by a macro expansion
+// count for the file of the macro invocation.
+void pp_report_count_output_tokens(TokenArray* pp_tokens);
+
+void pp_report_write(FILE* out, bool json);
+
+#endif
@@ -1,9 +1,11 @@
 #include "preprocess.h"
 #include <libgen.h>
-#include <unistd.h>
+#include <limits.h>
+#include "../lib/arena.h"
 #include "../lib/common.h"
-#include "parse.h"
-#include "sys.h"
+#include "../ducc/version.h"
+#include "atom.h"
+#include "pp_report.h"
 #include "tokenize.h"
 
 typedef enum {
@@ -34,6 +36,16 @@ typedef struct {
     const char* name;
     TokenArray parameters;
     TokenArray replacements;
+    // The value of MacroArray's `generation` when this name was last defined or undefined.
+    int generation;
+    // Object-like macros keep the result of their last expansion and rescan if it did not depend on the context, along
+    // with the names looked up while rescanning it. It is used until one of those names is defined or undefined again.
+    bool has_cached_expansion;
+    TokenArray cached_expansion;
+    StrArray cached_expansion_deps;
+    // The generation when the cached expansion was made, and when its names were last found unchanged.
+    int cached_expansion_generation;
+    int cached_expansion_checked_generation;
 } Macro;
 
 void macro_build_json(JsonBuilder* builder, Macro* macro) {
@@ -60,24 +72,62 @@ static int macro_find_param(Macro* macro, Token* tok) {
         return -1;
 
     for (size_t i = 0; i < macro->parameters.len; ++i) {
-        if (strcmp(macro->parameters.data[i].value.string, tok->value.string) == 0) {
+        if (macro->parameters.data[i].value.string == tok->value.string) {
             return i;
         }
     }
     return -1;
 }
 
+// Macros by name. `index` is an open-addressing hash table with linear probing that maps a name to its entry in `data`,
+// or -1 for an empty slot. Names are atoms, so slots are compared by pointer and hashed by their atom IDs. A name is
+// added to the index once and never removed: redefining a macro reuses its entry, and #undef only marks the entry
+// undefined, so no tombstones build up.
 typedef struct {
     size_t len;
     size_t capacity;
     Macro* data;
+    // Bitset over the entries in `data` of the macros whose expansions are being rescanned, which are not expanded
+    // again until the rescan is over.
+    unsigned char* expanding;
+    int expanding_count;
+    int* index;
+    size_t index_capacity;
+    // log2(index_capacity)
+    int index_bits;
+    // Counts every #define and #undef, so that a cached expansion can tell whether the macros it used have changed.
+    int generation;
+    // The names looked up while rescanning object-like macros, for their cached expansions. A nested rescan appends to
+    // the same log, so its names are also those of the enclosing one. The log is emptied when the outermost one ends.
+    StrArray expansion_deps;
+    int expansion_recording_depth;
 } MacroArray;
 
+static MacroTableStats macro_table_counters;
+
+const MacroTableStats* macro_table_stats() {
+    return &macro_table_counters;
+}
+
+static void macros_index_init(MacroArray* macros, int bits) {
+    size_t capacity = (size_t)1 << bits;
+    macros->index_bits = bits;
+    macros->index_capacity = capacity;
+    macros->index = calloc(capacity, sizeof(int));
+    for (size_t i = 0; i < capacity; ++i) {
+        macros->index[i] = -1;
+    }
+    macro_table_counters.index_capacity = capacity;
+}
+
 static MacroArray* macros_new() {
     MacroArray* macros = calloc(1, sizeof(MacroArray));
     macros->len = 0;
     macros->capacity = 8;
     macros->data = calloc(macros->capacity, sizeof(Macro));
+    macros->expanding = calloc(macros->capacity / 8, sizeof(unsigned char));
+    macros_index_init(macros, 10);
+    strings_init(&macros->expansion_deps);
     return macros;
 }
 
@@ -89,17 +139,90 @@ static void macros_reserve(MacroArray* macros, size_t size) {
     }
     macros->data = realloc(macros->data, macros->capacity * sizeof(Macro));
     memset(macros->data + macros->len, 0, (macros->capacity - macros->len) * sizeof(Macro));
+    // The capacity stays a power of two, at least 8.
+    size_t expanding_len = (macros->len + 7) / 8;
+    macros->expanding = realloc(macros->expanding, macros->capacity / 8 * sizeof(unsigned char));
+    memset(macros->expanding + expanding_len, 0, macros->capacity / 8 - expanding_len);
+}
+
+static bool macros_is_expanding(MacroArray* macros, int i) {
+    return (macros->expanding[i / 8] >> (i % 8)) & 1;
+}
+
+static void macros_set_expanding(MacroArray* macros, int i, bool expanding) {
+    if (macros_is_expanding(macros, i) != expanding) {
+        macros->expanding_count += expanding ? 1 : -1;
+    }
+    if (expanding) {
+        macros->expanding[i / 8] |= 1 << (i % 8);
+    } else {
+        macros->expanding[i / 8] &= ~(1 << (i % 8));
+    }
+}
+
+// Returns the slot of `name` in the index, or the empty slot where it would go.
+static size_t macros_index_slot(MacroArray* macros, const char* name) {
+    size_t mask = macros->index_capacity - 1;
+    size_t slot = atom_hash(name, macros->index_bits);
+    int probes = 1;
+    while (macros->index[slot] != -1 && macros->data[macros->index[slot]].name != name) {
+        slot = (slot + 1) & mask;
+        ++probes;
+    }
+    ++macro_table_counters.lookups;
+    macro_table_counters.probes += probes;
+    if (macro_table_counters.max_probes < probes) {
+        macro_table_counters.max_probes = probes;
+    }
+    return slot;
+}
+
+static void macros_index_grow(MacroArray* macros) {
+    int* old_index = macros->index;
+    size_t old_capacity = macros->index_capacity;
+    macros_index_init(macros, macros->index_bits + 1);
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old_index[i] != -1) {
+            macros->index[macros_index_slot(macros, macros->data[old_index[i]].name)] = old_index[i];
+        }
+    }
+    free(old_index);
+}
+
+// Returns the entry of the macro `name`, which may be undefined, or -1 if no macro of that name has been defined.
+static int macros_find(MacroArray* macros, const char* name) {
+    return macros->index[macros_index_slot(macros, name)];
 }
 
-static Macro* macros_push_new(MacroArray* macros) {
+// Returns a cleared entry for a new definition of `name`, reusing the entry of any earlier definition.
+static Macro* macros_define(MacroArray* macros, const char* name) {
+    size_t slot = macros_index_slot(macros, name);
+    if (macros->index[slot] != -1) {
+        Macro* m = &macros->data[macros->index[slot]];
+        memset(m, 0, sizeof(Macro));
+        m->name = name;
+        m->generation = ++macros->generation;
+        return m;
+    }
+
+    // Keep the index at most half full.
+    if ((macros->len + 1) * 2 > macros->index_capacity) {
+        macros_index_grow(macros);
+        slot = macros_index_slot(macros, name);
+    }
     macros_reserve(macros, macros->len + 1);
-    return &macros->data[macros->len++];
+    int i = macros->len++;
+    macros->index[slot] = i;
+    macro_table_counters.names = macros->len;
+    Macro* m = &macros->data[i];
+    m->name = name;
+    m->generation = ++macros->generation;
+    return m;
 }
 
 static void define_macro_to_number(MacroArray* macros, const char* name, int n) {
-    Macro* m = macros_push_new(macros);
+    Macro* m = macros_define(macros, atom_intern_string(name));
     m->kind = MacroKind_obj;
-    m->name = name;
     tokens_init(&m->replacements, 1);
     Token* tok = tokens_push_new(&m->replacements);
     tok->kind = TokenKind_literal_int;
@@ -109,13 +232,16 @@ static void define_macro_to_number(MacroArray* macros, const char* name, int n)
 static void add_predefined_macros(MacroArray* macros) {
     Macro* m;
 
-    m = macros_push_new(macros);
+    m = macros_define(macros, atom_name(Atom___FILE__));
     m->kind = MacroKind_builtin_file;
-    m->name = "__FILE__";
 
-    m = macros_push_new(macros);
+    m = macros_define(macros, atom_name(Atom___LINE__));
     m->kind = MacroKind_builtin_line;
-    m->name = "__LINE__";
+
+    // Results of __has_embed.
+    define_macro_to_number(macros, "__STDC_EMBED_NOT_FOUND__", 0);
+    define_macro_to_number(macros, "__STDC_EMBED_FOUND__", 1);
+    define_macro_to_number(macros, "__STDC_EMBED_EMPTY__", 2);
 
     // Non-standard pre-defined macros.
     define_macro_to_number(macros, "__ducc__", 1);
@@ -182,16 +308,11 @@ static void add_predefined_macros(MacroArray* macros) {
 
 // Accept "FOO" or "FOO=value"
 static void define_macro_from_string(MacroArray* macros, const char* def) {
-    Macro* m = macros_push_new(macros);
-    m->kind = MacroKind_obj;
-
     const char* eq = strchr(def, '=');
     if (eq) {
         // FOO=value format
-        size_t name_len = eq - def;
-        char* name = calloc(name_len + 1, sizeof(char));
-        memcpy(name, def, name_len);
-        m->name = name;
+        Macro* m = macros_define(macros, atom_intern(def, eq - def));
+        m->kind = MacroKind_obj;
 
         const char* value = eq + 1;
         tokens_init(&m->replacements, 1);
@@ -205,11 +326,12 @@ static void define_macro_from_string(MacroArray* macros, const char* def) {
             tok->value.integer = int_val;
         } else {
             tok->kind = TokenKind_ident;
-            tok->value.string = value;
+            tok->value.string = atom_intern_string(value);
         }
     } else {
         // FOO format (equivalent to FOO=1)
-        m->name = def;
+        Macro* m = macros_define(macros, atom_intern_string(def));
+        m->kind = MacroKind_obj;
         tokens_init(&m->replacements, 1);
         Token* tok = tokens_push_new(&m->replacements);
         tok->kind = TokenKind_literal_int;
@@ -291,23 +413,89 @@ void macroargs_build_json(JsonBuilder* builder, MacroArgArray* macroargs) {
     jsonbuilder_object_end(builder);
 }
 
+// What is known about a file that has been included, for skipping it when it is included again.
+typedef struct {
+    // Canonical path, see infile_canonical_path().
+    const char* path;
+    // The macro of the include guard wrapping the whole file, or NULL if there is none.
+    const char* guard_macro;
+    bool pragma_once;
+} FileGuard;
+
+typedef struct {
+    size_t len;
+    size_t capacity;
+    FileGuard* data;
+    // Indices into `data` by path. Paths are atoms, see infile_canonical_path().
+    AtomMap index;
+} FileGuardArray;
+
+static FileGuardArray* file_guards_new() {
+    FileGuardArray* guards = calloc(1, sizeof(FileGuardArray));
+    guards->len = 0;
+    guards->capacity = 8;
+    guards->data = calloc(guards->capacity, sizeof(FileGuard));
+    atom_map_init(&guards->index, 5);
+    return guards;
+}
+
+static void file_guards_reserve(FileGuardArray* guards, size_t size) {
+    if (size <= guards->capacity)
+        return;
+    while (guards->capacity < size) {
+        guards->capacity *= 2;
+    }
+    guards->data = realloc(guards->data, guards->capacity * sizeof(FileGuard));
+    memset(guards->data + guards->len, 0, (guards->capacity - guards->len) * sizeof(FileGuard));
+}
+
+static FileGuard* file_guards_find(FileGuardArray* guards, const char* path) {
+    int i = atom_map_get(&guards->index, path);
+    return i == -1 ? NULL : &guards->data[i];
+}
+
+static FileGuard* file_guards_get(FileGuardArray* guards, const char* path) {
+    AtomMapEntry* entry = atom_map_entry(&guards->index, path);
+    if (entry->value != -1) {
+        return &guards->data[entry->value];
+    }
+    entry->value = guards->len;
+    file_guards_reserve(guards, guards->len + 1);
+    FileGuard* guard = &guards->data[guards->len++];
+    guard->path = path;
+    return guard;
+}
+
 typedef struct {
+    // A gap buffer: the tokens from index `gap_start` on are stored `gap_len` slots further on. Tokens are replaced by
+    // moving the gap to them first, so a replacement costs the distance from the previous one, which is short while a
+    // line is being expanded from left to right, rather than the number of tokens after it.
     TokenArray* pp_tokens;
+    int gap_start;
+    int gap_len;
     int pos;
+    // Fills `pp_tokens` on demand. NULL if all the tokens are already there, e.g. for a macro argument.
+    Lexer* lexer;
     MacroArray* macros;
     int include_depth;
     StrArray* include_paths;
     StrArray* included_files;
+    FileGuardArray* file_guards;
     bool generate_system_deps;
     bool generate_user_deps;
+    // Only the dependencies are wanted (-M and -MM): text lines are skipped without being lexed, let alone expanded.
+    bool deps_only;
+    // Directive lines from this index on are still to be removed by remove_pp_directives().
+    int directives_start;
 } Preprocessor;
 
-static TokenArray* do_preprocess(InFile* src, int depth, MacroArray* macros, StrArray* include_paths,
-                                 StrArray* included_files, bool generate_system_deps, bool generate_user_deps);
+static void do_preprocess(TokenArray* pp_tokens, InFile* src, int depth, MacroArray* macros, StrArray* include_paths,
+                          StrArray* included_files, FileGuardArray* file_guards, bool generate_system_deps,
+                          bool generate_user_deps, bool deps_only);
 
 static Preprocessor* preprocessor_new(TokenArray* pp_tokens, int include_depth, MacroArray* macros,
-                                      StrArray* include_paths, StrArray* included_files, bool generate_system_deps,
-                                      bool generate_user_deps) {
+                                      StrArray* include_paths, StrArray* included_files, FileGuardArray* file_guards,
+                                      bool generate_system_deps, bool generate_user_deps, bool deps_only) {
     if (include_depth >= 32) {
         fatal_error("include depth limit exceeded");
     }
@@ -318,16 +506,60 @@ static Preprocessor* preprocessor_new(TokenArray* pp_tokens, int include_depth,
     pp->include_depth = include_depth;
     pp->include_paths = include_paths;
     pp->included_files = included_files;
+    pp->file_guards = file_guards;
     pp->generate_system_deps = generate_system_deps;
     pp->generate_user_deps = generate_user_deps;
+    pp->deps_only = deps_only;
 
     return pp;
 }
 
+// Number of tokens, not counting the gap.
+static int pp_tokens_len(Preprocessor* pp) {
+    return pp->pp_tokens->len - pp->gap_len;
+}
+
 static Token* pp_token_at(Preprocessor* pp, int i) {
+    while (pp->lexer && i >= pp_tokens_len(pp) && !pp->lexer->reached_eof) {
+        lexer_next(pp->lexer);
+    }
+    if (i >= pp->gap_start) {
+        i += pp->gap_len;
+    }
     return &pp->pp_tokens->data[i];
 }
 
+// Moves the gap to index `pos` and makes it at least `size` slots long.
+static void pp_move_gap(Preprocessor* pp, int pos, int size) {
+    Token* data = pp->pp_tokens->data;
+    if (pp->gap_len > 0) {
+        if (pos < pp->gap_start) {
+            memmove(&data[pos + pp->gap_len], &data[pos], (pp->gap_start - pos) * sizeof(Token));
+        } else if (pp->gap_start < pos) {
+            memmove(&data[pp->gap_start], &data[pp->gap_start + pp->gap_len], (pos - pp->gap_start) * sizeof(Token));
+        }
+    }
+    pp->gap_start = pos;
+
+    if (pp->gap_len < size) {
+        int tail_len = pp_tokens_len(pp) - pos;
+        // Grow by half the tokens after the gap as well, so that the cost of moving them is amortized.
+        int extra = size - pp->gap_len + tail_len / 2;
+        tokens_reserve(pp->pp_tokens, pp->pp_tokens->len + extra);
+        data = pp->pp_tokens->data;
+        memmove(&data[pos + pp->gap_len + extra], &data[pos + pp->gap_len], tail_len * sizeof(Token));
+        pp->pp_tokens->len += extra;
+        pp->gap_len += extra;
+    }
+}
+
+// Drops the gap, so that `pp_tokens` is a plain array again.
+static void pp_close_gap(Preprocessor* pp) {
+    pp_move_gap(pp, pp_tokens_len(pp), 0);
+    pp->pp_tokens->len -= pp->gap_len;
+    pp->gap_len = 0;
+}
+
 static Token* peek_pp_token(Preprocessor* pp) {
     return pp_token_at(pp, pp->pos);
 }
@@ -362,8 +594,8 @@ static Token* expect_pp_token(Preprocessor* pp, TokenKind expected) {
     if (tok->kind == expected) {
         return tok;
     }
-    fatal_error("%s:%d: expected '%s', but got '%s'", tok->loc.filename, tok->loc.line, token_kind_stringify(expected),
-                token_stringify(tok));
+    fatal_error("%s:%d: expected '%s', but got '%s'", token_filename(tok), token_line(tok),
+                token_kind_stringify(expected), token_stringify(tok));
 }
 
 static bool pp_eof(Preprocessor* pp) {
@@ -371,36 +603,50 @@ static bool pp_eof(Preprocessor* pp) {
 }
 
 static int find_macro(Preprocessor* pp, const char* name) {
-    for (size_t i = 0; i < pp->macros->len; ++i) {
-        if (pp->macros->data[i].kind == MacroKind_undef)
-            continue;
-        if (strcmp(pp->macros->data[i].name, name) == 0) {
-            return i;
-        }
+    int i = macros_find(pp->macros, name);
+    if (i == -1 || pp->macros->data[i].kind == MacroKind_undef) {
+        return -1;
     }
-    return -1;
+    return i;
+}
+
+// For 'defined', #ifdef and #ifndef. __has_include and __has_embed are not macros, but they count as defined so that
+// their availability can be tested, as in GCC and Clang.
+static bool is_macro_defined(Preprocessor* pp, const char* name) {
+    return find_macro(pp, name) != -1 || atom_id(name) == Atom___has_include || atom_id(name) == Atom___has_embed;
 }
 
 static void undef_macro(Preprocessor* pp, int idx) {
     pp->macros->data[idx].kind = MacroKind_undef;
+    pp->macros->data[idx].generation = ++pp->macros->generation;
     // TODO: Can predefined macro like __FILE__ be undefined?
 }
 
-static void skip_whitespaces(Preprocessor* pp) {
-    while (!pp_eof(pp) && consume_pp_token_if(pp, TokenKind_whitespace))
-        ;
+// Whether the current line has ended, i.e. the next token starts a new line.
+static bool pp_at_line_end(Preprocessor* pp) {
+    if (pp->lexer && pp->pos == pp_tokens_len(pp) && !pp->lexer->reached_eof) {
+        // The next token has not been lexed yet. Leave it so, as it may be the first line of a skipped group.
+        return lexer_at_line_end(pp->lexer);
+    }
+    Token* tok = peek_pp_token(pp);
+    return tok->kind == TokenKind_eof || (tok->flags & TokenFlag_at_bol);
 }
 
-static void skip_whitespaces_or_newlines(Preprocessor* pp, bool skip_newline) {
-    while (!pp_eof(pp) && (consume_pp_token_if(pp, TokenKind_whitespace) ||
-                           (skip_newline && consume_pp_token_if(pp, TokenKind_newline))))
-        ;
+static void seek_to_next_line(Preprocessor* pp) {
+    while (!pp_at_line_end(pp))
+        next_pp_token(pp);
 }
 
-// It will not consume a new-line token.
-static void seek_to_next_newline(Preprocessor* pp) {
-    while (!pp_eof(pp) && consume_pp_token_if_not(pp, TokenKind_newline))
-        ;
+// Ends a directive. Its new-line is not written by -E, so it is taken off the count of the next line's first token.
+static void expect_pp_newline(Preprocessor* pp) {
+    Token* tok = peek_pp_token(pp);
+    if (!pp_at_line_end(pp)) {
+        fatal_error("%s:%d: expected '%s', but got '%s'", token_filename(tok), token_line(tok),
+                    token_kind_stringify(TokenKind_newline), token_stringify(tok));
+    }
+    if (tok->newlines > 0) {
+        --tok->newlines;
+    }
 }
 
 static void make_tokens_removed(Preprocessor* pp, int start, int end) {
@@ -414,76 +660,204 @@ static void make_tokens_removed(Preprocessor* pp, int start, int end) {
 static Token* read_include_header_name(Preprocessor* pp) {
     Token* tok = next_pp_token(pp);
     if (tok->kind != TokenKind_header_name) {
-        fatal_error("%s:%d: invalid #include, %s", tok->loc.filename, tok->loc.line, token_stringify(tok));
+        fatal_error("%s:%d: invalid #include, %s", token_filename(tok), token_line(tok), token_stringify(tok));
     }
     return tok;
 }
 
+// Nonzero at the atom ID of each path in the dependency list, so that a file is listed once however many times it is
+// included, without comparing it against every file listed so far.
+static IntArray recorded_file_ids;
+
+static void record_included_file(StrArray* included_files, const char* path) {
+    if (!recorded_file_ids.data) {
+        ints_init(&recorded_file_ids);
+    }
+    int id = atom_id(atom_intern_string(path));
+    if (recorded_file_ids.len <= (size_t)id) {
+        // The slots up to the new length are zero: ints_reserve() clears everything past the old one.
+        ints_reserve(&recorded_file_ids, id + 1);
+        recorded_file_ids.len = id + 1;
+    }
+    if (!recorded_file_ids.data[id]) {
+        recorded_file_ids.data[id] = 1;
+        strings_push(included_files, path);
+    }
+}
+
+// Results of include name resolution, kept for the whole process and including the names that were not found, so that
+// a header name costs file system lookups only the first time it is resolved from a given place. An entry is keyed by
+// the index of the first include path searched and the name, an atom. The table uses open addressing with linear
+// probing; a NULL name marks an empty slot.
+typedef struct {
+    int start;
+    const char* name;
+    // The resolved file name, or NULL if it was not found.
+    const char* path;
+    // Index of the include path the file was found in, or -1.
+    int path_index;
+} IncludeResolution;
+
+typedef struct {
+    size_t len;
+    size_t capacity;
+    IncludeResolution* data;
+    // log2(capacity)
+    int bits;
+} IncludeCache;
+
+static IncludeCache include_cache;
+
+static void include_cache_init(int bits) {
+    include_cache.len = 0;
+    include_cache.bits = bits;
+    include_cache.capacity = (size_t)1 << bits;
+    include_cache.data = calloc(include_cache.capacity, sizeof(IncludeResolution));
+}
+
+static size_t include_cache_slot(int start, const char* name) {
+    size_t mask = include_cache.capacity - 1;
+    size_t slot = hash_mix((size_t)atom_id(name) * 31 + start, include_cache.bits);
+    while (include_cache.data[slot].name &&
+           (include_cache.data[slot].name != name || include_cache.data[slot].start != start)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static IncludeResolution* include_cache_find(int start, const char* name) {
+    if (!include_cache.data) {
+        return NULL;
+    }
+    IncludeResolution* r = &include_cache.data[include_cache_slot(start, name)];
+    return r->name ? r : NULL;
+}
+
+static void include_cache_add(int start, const char* name, const char* path, int path_index) {
+    if (!include_cache.data) {
+        include_cache_init(6);
+    }
+    // Keep the table at most half full.
+    if ((include_cache.len + 1) * 2 > include_cache.capacity) {
+        IncludeResolution* old_data = include_cache.data;
+        size_t old_capacity = include_cache.capacity;
+        include_cache_init(include_cache.bits + 1);
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_data[i].name) {
+                include_cache.data[include_cache_slot(old_data[i].start, old_data[i].name)] = old_data[i];
+                ++include_cache.len;
+            }
+        }
+        free(old_data);
+    }
+    IncludeResolution* r = &include_cache.data[include_cache_slot(start, name)];
+    r->start = start;
+    r->name = name;
+    r->path = path;
+    r->path_index = path_index;
+    ++include_cache.len;
+}
+
+// Searches the include paths from index `start` on for `include_name`, a header name in angle brackets or quotes.
+// Returns the index of the path it was found in and sets `*resolved`, or returns -1.
+static int search_include_paths(Preprocessor* pp, const char* include_name, int start, const char** resolved) {
+    const char* name = atom_intern_string(include_name);
+    IncludeResolution* r = include_cache_find(start, name);
+    if (r) {
+        *resolved = r->path;
+        return r->path_index;
+    }
+
+    const char* path = NULL;
+    int path_index = -1;
+    for (size_t i = start; i < pp->include_paths->len; ++i) {
+        char* buf = calloc(strlen(include_name) - 2 + 1 + strlen(pp->include_paths->data[i]) + 1, sizeof(char));
+        sprintf(buf, "%s/%.*s", pp->include_paths->data[i], (int)(strlen(include_name) - 2), include_name + 1);
+        if (infile_exists(buf)) {
+            path = buf;
+            path_index = i;
+            break;
+        }
+        free(buf);
+    }
+    include_cache_add(start, name, path, path_index);
+    *resolved = path;
+    return path_index;
+}
+
 static const char* resolve_include_name(Preprocessor* pp, const Token* include_name_token) {
     const char* include_name = include_name_token->value.string;
     if (include_name[0] == '"') {
-        char* current_filename = strdup(include_name_token->loc.filename);
+        char* current_filename = strdup(token_filename(include_name_token));
         const char* current_dir = dirname(current_filename);
         char* buf = calloc(strlen(include_name) - 2 + 1 + strlen(current_dir) + 1, sizeof(char));
         sprintf(buf, "%s/%.*s", current_dir, (int)(strlen(include_name) - 2), include_name + 1);
         return buf;
     } else {
-        for (size_t i = 0; i < pp->include_paths->len; ++i) {
-            char* buf = calloc(strlen(include_name) - 2 + 1 + strlen(pp->include_paths->data[i]) + 1, sizeof(char));
-            sprintf(buf, "%s/%.*s", pp->include_paths->data[i], (int)(strlen(include_name) - 2), include_name + 1);
-            if (access(buf, F_OK | R_OK) == 0) {
-                return buf;
-            }
-        }
-        return NULL;
+        const char* path;
+        search_include_paths(pp, include_name, 0, &path);
+        return path;
     }
 }
 
+// #include_next starts the search after the include path the current file was found in, or from the first one if it
+// was not found through the include paths.
 static const char* resolve_next_include_name(Preprocessor* pp, const Token* include_name_token) {
     const char* include_name = include_name_token->value.string;
-    char* current_filename = strdup(include_name_token->loc.filename);
+    const char* current_filename = token_filename(include_name_token);
+    int start = 0;
     for (size_t i = 0; i < pp->include_paths->len; ++i) {
-        char* buf = calloc(strlen(include_name) - 2 + 1 + strlen(pp->include_paths->data[i]) + 1, sizeof(char));
-        sprintf(buf, "%s/%.*s", pp->include_paths->data[i], (int)(strlen(include_name) - 2), include_name + 1);
-        if (strcmp(buf, current_filename) == 0) {
-            // #include_next skips the same file.
-            continue;
-        }
-        if (access(buf, F_OK | R_OK) == 0) {
-            return buf;
+        const char* dir = pp->include_paths->data[i];
+        size_t dir_len = strlen(dir);
+        if (strncmp(current_filename, dir, dir_len) == 0 && current_filename[dir_len] == '/' &&
+            strlen(current_filename + dir_len + 1) == strlen(include_name) - 2 &&
+            strncmp(current_filename + dir_len + 1, include_name + 1, strlen(include_name) - 2) == 0) {
+            start = i + 1;
+            break;
         }
     }
-    return NULL;
+    const char* path;
+    search_include_paths(pp, include_name, start, &path);
+    return path;
 }
 
+// The first of the new tokens takes over the flags and new-lines of the first replaced one, so that a replacement stays
+// where the original was in the line structure. If nothing replaces them, the new-lines and the start of the line are
+// passed on to the next token.
 static int replace_pp_tokens(Preprocessor* pp, int dest_start, int dest_end, TokenArray* source_tokens) {
-    size_t n_tokens_to_remove = dest_end - dest_start;
-    size_t n_tokens_after_dest = pp->pp_tokens->len - dest_end;
-    size_t shift_amount;
-
-    if (n_tokens_to_remove < source_tokens->len) {
-        // Move existing tokens backward to make room.
-        shift_amount = source_tokens->len - n_tokens_to_remove;
-        tokens_reserve(pp->pp_tokens, pp->pp_tokens->len + shift_amount);
-        memmove(pp_token_at(pp, dest_end + shift_amount), pp_token_at(pp, dest_end),
-                n_tokens_after_dest * sizeof(Token));
-        pp->pp_tokens->len += shift_amount;
-    } else if (source_tokens->len < n_tokens_to_remove) {
-        // Move existing tokens forward to reduce room.
-        shift_amount = n_tokens_to_remove - source_tokens->len;
-        memmove(pp_token_at(pp, dest_start + source_tokens->len), pp_token_at(pp, dest_end),
-                n_tokens_after_dest * sizeof(Token));
-        pp->pp_tokens->len -= shift_amount;
-        memset(pp_token_at(pp, pp->pp_tokens->len), 0, shift_amount * sizeof(Token));
-    }
-
-    memcpy(pp_token_at(pp, dest_start), source_tokens->data, source_tokens->len * sizeof(Token));
+    // Make sure that the token after the range has been lexed.
+    pp_token_at(pp, dest_end);
+
+    int flags = 0;
+    int newlines = 0;
+    if (dest_start < dest_end) {
+        flags = pp_token_at(pp, dest_start)->flags;
+        newlines = pp_token_at(pp, dest_start)->newlines;
+    }
 
-    return dest_start + source_tokens->len;
-}
+    // The replaced tokens become part of the gap, and the new ones are taken from its start.
+    pp_move_gap(pp, dest_end, 0);
+    pp->gap_start = dest_start;
+    pp->gap_len += dest_end - dest_start;
+    pp_move_gap(pp, dest_start, source_tokens->len);
+    memcpy(&pp->pp_tokens->data[dest_start], source_tokens->data, source_tokens->len * sizeof(Token));
+    pp->gap_start += source_tokens->len;
+    pp->gap_len -= source_tokens->len;
+
+    if (dest_start < dest_end) {
+        if (source_tokens->len > 0) {
+            // Whether the token may be expanded is its own, though.
+            Token* first = pp_token_at(pp, dest_start);
+            first->flags = (flags & ~TokenFlag_no_expand) | (first->flags & TokenFlag_no_expand);
+            first->newlines = newlines;
+        } else if (dest_start < pp_tokens_len(pp)) {
+            Token* next = pp_token_at(pp, dest_start);
+            next->flags |= flags & TokenFlag_at_bol;
+            next->newlines = next->newlines + newlines < CHAR_MAX ? next->newlines + newlines : CHAR_MAX;
+        }
+    }
 
-static int insert_pp_tokens(Preprocessor* pp, int dest_pos, TokenArray* source_tokens) {
-    return replace_pp_tokens(pp, dest_pos, dest_pos, source_tokens);
+    return dest_start + source_tokens->len;
 }
 
 static void replace_single_pp_token(Preprocessor* pp, int dest, Token* source_tok) {
@@ -493,36 +867,61 @@ static void replace_single_pp_token(Preprocessor* pp, int dest, Token* source_to
     replace_pp_tokens(pp, dest, dest + 1, &tokens);
 }
 
+static int replace_pp_tokens_with_int(Preprocessor* pp, int dest_start, int dest_end, int value) {
+    TokenArray tokens;
+    tokens_init(&tokens, 1);
+    Token* tok = tokens_push_new(&tokens);
+    tok->kind = TokenKind_literal_int;
+    tok->value.integer = value;
+    return replace_pp_tokens(pp, dest_start, dest_end, &tokens);
+}
+
+static void remove_pp_directives(Preprocessor* pp, int start, int end);
+
 static void expand_include_directive(Preprocessor* pp, const char* include_name, Token* original_include_name_tok) {
+    // Including the file again would produce no tokens, so it is not even opened.
+    FileGuard* guard = file_guards_find(pp->file_guards, infile_canonical_path(include_name));
+    if (guard && (guard->pragma_once || (guard->guard_macro && find_macro(pp, guard->guard_macro) != -1))) {
+        pp_report_guarded_include(include_name);
+        return;
+    }
+
     InFile* include_source = infile_open(include_name);
     if (!include_source) {
-        fatal_error("%s:%d: cannot open include file: %s", original_include_name_tok->loc.filename,
-                    original_include_name_tok->loc.line, token_stringify(original_include_name_tok));
+        fatal_error("%s:%d: cannot open include file: %s", token_filename(original_include_name_tok),
+                    token_line(original_include_name_tok), token_stringify(original_include_name_tok));
     }
 
-    TokenArray* include_pp_tokens = do_preprocess(include_source, pp->include_depth + 1, pp->macros, pp->include_paths,
-                                                  pp->included_files, pp->generate_system_deps, pp->generate_user_deps);
-    tokens_pop(include_pp_tokens); // pop EOF token
-    pp->pos = insert_pp_tokens(pp, pp->pos, include_pp_tokens);
+    // The included file is preprocessed straight into the end of the same token array. Only the token after the
+    // #include line has been lexed so far; it is taken out meanwhile and put back after the included tokens.
+    pp_close_gap(pp);
+    remove_pp_directives(pp, pp->directives_start, pp->pos);
+    assert(pp->pos + 1 == pp_tokens_len(pp));
+    Token next_tok = *tokens_pop(pp->pp_tokens);
+
+    do_preprocess(pp->pp_tokens, include_source, pp->include_depth + 1, pp->macros, pp->include_paths,
+                  pp->included_files, pp->file_guards, pp->generate_system_deps, pp->generate_user_deps, pp->deps_only);
+    // The EOF token still holds the new-lines at the end of the file.
+    pp->pp_tokens->data[pp->pp_tokens->len - 1].kind = TokenKind_removed;
+
+    *tokens_push_new(pp->pp_tokens) = next_tok;
+    pp->pos = pp_tokens_len(pp) - 1;
+    pp->directives_start = pp->pos;
 }
 
-// ws ::= many0(<whitespace>)
-// macro-parameters ::= '(' <ws> opt(<identifier> <ws> many0(',' <ws> <identifier> <ws>)) ')'
+// macro-parameters ::= '(' opt(<identifier> many0(',' <identifier>)) ')'
 static TokenArray* pp_parse_macro_parameters(Preprocessor* pp) {
     TokenArray* parameters = calloc(1, sizeof(TokenArray));
     tokens_init(parameters, 2);
 
     // '(' is consumed by caller.
-    skip_whitespaces(pp);
     Token* tok = consume_pp_token_if(pp, TokenKind_ident);
     if (tok) {
         *tokens_push_new(parameters) = *tok;
-        skip_whitespaces(pp);
         while (consume_pp_token_if(pp, TokenKind_comma)) {
-            skip_whitespaces(pp);
             tok = next_pp_token(pp);
             if (tok->kind != TokenKind_ident) {
-                fatal_error("%s:%d: invalid macro syntax", tok->loc.filename, tok->loc.line);
+                fatal_error("%s:%d: invalid macro syntax", token_filename(tok), token_line(tok));
             }
             *tokens_push_new(parameters) = *tok;
         }
@@ -532,20 +931,29 @@ static TokenArray* pp_parse_macro_parameters(Preprocessor* pp) {
     return parameters;
 }
 
-// ws ::= many0(<whitespace>)
-// macro-arguments ::= <ws> '(' <ws> opt(<any-token> <ws> many0(',' <ws> <any-token> <ws>)) ')'
+// Fails if the arguments of a macro invocation in a directive run past the end of the line.
+static void expect_macro_arguments_continue(Preprocessor* pp, bool skip_newline) {
+    if (!skip_newline && pp_at_line_end(pp)) {
+        Token* last = pp_token_at(pp, pp->pos - 1);
+        fatal_error("%s:%d: expected '%s', but got '%s'", token_filename(last), token_line(last),
+                    token_kind_stringify(TokenKind_paren_r), token_kind_stringify(TokenKind_newline));
+    }
+}
+
+// macro-arguments ::= '(' opt(<any-token> many0(',' <any-token>)) ')'
+//
+// Unless `skip_newline` is set, i.e. in a directive, the invocation must not continue to the next line.
 static MacroArgArray* pp_parse_macro_arguments(Preprocessor* pp, bool skip_newline) {
     MacroArgArray* args = macroargs_new();
 
-    skip_whitespaces_or_newlines(pp, skip_newline);
+    if (!skip_newline && pp_at_line_end(pp)) {
+        return NULL;
+    }
     if (!consume_pp_token_if(pp, TokenKind_paren_l)) {
         return NULL;
     }
-    skip_whitespaces_or_newlines(pp, skip_newline);
+    expect_macro_arguments_continue(pp, skip_newline);
     Token* tok = peek_pp_token(pp);
-    if (!skip_newline && tok->kind == TokenKind_newline) {
-        expect_pp_token(pp, TokenKind_paren_r);
-    }
     if (tok->kind != TokenKind_paren_r) {
         MacroArg* arg = macroargs_push_new(args);
         tokens_init(&arg->tokens, 4);
@@ -561,7 +969,7 @@ static MacroArgArray* pp_parse_macro_arguments(Preprocessor* pp, bool skip_newli
                 }
                 if (tok->kind == TokenKind_comma) {
                     next_pp_token(pp);
-                    skip_whitespaces_or_newlines(pp, skip_newline);
+                    expect_macro_arguments_continue(pp, skip_newline);
 
                     arg = macroargs_push_new(args);
                     tokens_init(&arg->tokens, 4);
@@ -580,10 +988,16 @@ static MacroArgArray* pp_parse_macro_arguments(Preprocessor* pp, bool skip_newli
 
             tok = next_pp_token(pp);
             if (tok->kind != TokenKind_removed) {
-                *tokens_push_new(&arg->tokens) = *tok;
+                Token* arg_tok = tokens_push_new(&arg->tokens);
+                *arg_tok = *tok;
+                // A new-line in the arguments is just whitespace.
+                if (arg_tok->flags & TokenFlag_at_bol) {
+                    arg_tok->flags = (arg_tok->flags & ~TokenFlag_at_bol) | TokenFlag_leading_space;
+                }
+                arg_tok->newlines = 0;
             }
 
-            skip_whitespaces_or_newlines(pp, skip_newline);
+            expect_macro_arguments_continue(pp, skip_newline);
         }
     }
     expect_pp_token(pp, TokenKind_paren_r);
@@ -618,7 +1032,7 @@ static Token* concat_two_tokens(Token* left, Token* right) {
     }
 
     // Concat
-    Token* result = calloc(1, sizeof(Token));
+    Token* result = arena_alloc(&token_arena, sizeof(Token));
 
     char* endptr;
     int val = strtol(builder.buf, &endptr, 10);
@@ -627,7 +1041,7 @@ static Token* concat_two_tokens(Token* left, Token* right) {
         result->value.integer = val;
     } else {
         result->kind = TokenKind_ident;
-        result->value.string = builder.buf;
+        result->value.string = atom_intern(builder.buf, builder.len);
     }
 
     return result;
@@ -637,18 +1051,11 @@ static Token* stringify_tokens(TokenArray* tokens) {
     StrBuilder builder;
     strbuilder_init(&builder);
 
-    bool prev_whitespace = false;
     for (size_t i = 0; i < tokens->len; ++i) {
         Token* tok = &tokens->data[i];
-        if (tok->kind == TokenKind_whitespace) {
-            prev_whitespace = true;
-            continue;
-        }
-
-        if (prev_whitespace && builder.len > 0) {
+        if ((tok->flags & TokenFlag_leading_space) && builder.len > 0) {
             strbuilder_append_char(&builder, ' ');
         }
-        prev_whitespace = false;
 
         const char* str = token_stringify(tok);
 
@@ -665,69 +1072,130 @@ static Token* stringify_tokens(TokenArray* tokens) {
         }
     }
 
-    Token* result = calloc(1, sizeof(Token));
+    Token* result = arena_alloc(&token_arena, sizeof(Token));
     result->kind = TokenKind_literal_str;
     result->value.string = builder.buf;
     return result;
 }
 
-typedef struct MacroExpansionContext {
-    // Stack of macro names that have been already expanded.
-    StrArray already_expanded;
-} MacroExpansionContext;
-
-MacroExpansionContext* macroexpansioncontext_new() {
-    MacroExpansionContext* ctx = calloc(1, sizeof(MacroExpansionContext));
-    strings_init(&ctx->already_expanded);
-    return ctx;
-}
-
-static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionContext* ctx);
+static int expand_macro(Preprocessor* pp, bool skip_newline);
 
-static void expand_macro_arg(Preprocessor* pp, MacroArg* arg, bool skip_newline, MacroExpansionContext* ctx) {
+static void expand_macro_arg(Preprocessor* pp, MacroArg* arg, bool skip_newline) {
     tokens_push_new(&arg->tokens)->kind = TokenKind_eof;
 
-    Preprocessor* pp2 = preprocessor_new(&arg->tokens, pp->include_depth, pp->macros, pp->include_paths,
-                                         pp->included_files, pp->generate_system_deps, pp->generate_user_deps);
+    Preprocessor* pp2 =
+        preprocessor_new(&arg->tokens, pp->include_depth, pp->macros, pp->include_paths, pp->included_files,
+                         pp->file_guards, pp->generate_system_deps, pp->generate_user_deps, pp->deps_only);
 
     size_t arg_token_count = arg->tokens.len;
     size_t processed_token_count = 0;
     while (processed_token_count < arg_token_count) {
         if (peek_pp_token(pp2)->kind == TokenKind_ident) {
-            processed_token_count += expand_macro(pp2, skip_newline, ctx);
+            processed_token_count += expand_macro(pp2, skip_newline);
         } else {
             next_pp_token(pp2);
             processed_token_count += 1;
         }
     }
 
+    pp_close_gap(pp2);
     tokens_pop(&arg->tokens);
 }
 
-static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionContext* ctx) {
-    if (ctx == NULL) {
-        ctx = macroexpansioncontext_new();
+// Whether the cached expansion of `macro` may be used here: none of the names it looked up has been defined or
+// undefined since, and none of them is being expanded, which would have stopped its expansion.
+static bool cached_expansion_is_usable(MacroArray* macros, Macro* macro) {
+    if (!macro->has_cached_expansion) {
+        return false;
+    }
+    if (macro->cached_expansion_checked_generation == macros->generation && macros->expanding_count == 0) {
+        return true;
+    }
+    for (size_t i = 0; i < macro->cached_expansion_deps.len; ++i) {
+        int dep_idx = macros_find(macros, macro->cached_expansion_deps.data[i]);
+        if (dep_idx == -1) {
+            continue;
+        }
+        if (macros->data[dep_idx].generation > macro->cached_expansion_generation) {
+            macro->has_cached_expansion = false;
+            return false;
+        }
+        if (macros_is_expanding(macros, dep_idx)) {
+            return false;
+        }
+    }
+    macro->cached_expansion_checked_generation = macros->generation;
+    return true;
+}
+
+// Caches the expansion of the object-like macro `macro_idx` in [start, end), which looked up the names in the
+// expansion log from `deps_start` on. It is not cached if it depends on the context: if it uses __FILE__ or __LINE__,
+// if a name it used was stopped by an enclosing expansion, or if it leaves the name of a function-like macro, which
+// could be invoked with the tokens after it elsewhere.
+static void cache_expansion(Preprocessor* pp, int macro_idx, int start, int end, size_t deps_start) {
+    MacroArray* macros = pp->macros;
+    StrArray* deps = &macros->expansion_deps;
+    for (size_t i = deps_start; i < deps->len; ++i) {
+        int dep_idx = macros_find(macros, deps->data[i]);
+        if (dep_idx == -1 || dep_idx == macro_idx) {
+            continue;
+        }
+        MacroKind kind = macros->data[dep_idx].kind;
+        if (kind == MacroKind_builtin_file || kind == MacroKind_builtin_line || macros_is_expanding(macros, dep_idx)) {
+            return;
+        }
+    }
+    for (int pos = start; pos < end; ++pos) {
+        Token* tok = pp_token_at(pp, pos);
+        if (tok->kind == TokenKind_ident && !(tok->flags & TokenFlag_no_expand)) {
+            int idx = find_macro(pp, tok->value.string);
+            if (idx != -1 && macros->data[idx].kind == MacroKind_func) {
+                return;
+            }
+        }
+    }
+
+    Macro* macro = &macros->data[macro_idx];
+    macro->has_cached_expansion = true;
+    tokens_init(&macro->cached_expansion, end - start);
+    for (int pos = start; pos < end; ++pos) {
+        *tokens_push_new(&macro->cached_expansion) = *pp_token_at(pp, pos);
+    }
+    strings_init(&macro->cached_expansion_deps);
+    strings_reserve(&macro->cached_expansion_deps, deps->len - deps_start);
+    for (size_t i = deps_start; i < deps->len; ++i) {
+        strings_push(&macro->cached_expansion_deps, deps->data[i]);
     }
+    macro->cached_expansion_generation = macros->generation;
+    macro->cached_expansion_checked_generation = macros->generation;
+    ++macro_table_counters.expansion_cache_stores;
+}
 
+static int expand_macro(Preprocessor* pp, bool skip_newline) {
     int macro_name_pos = pp->pos;
     Token* macro_name = peek_pp_token(pp);
-    const char* macro_name_str = macro_name->value.string;
-
-    // Supress expansion if the macro has already been expanded.
-    for (size_t i = 0; i < ctx->already_expanded.len; ++i) {
-        if (strcmp(ctx->already_expanded.data[i], macro_name->value.string) == 0) {
-            next_pp_token(pp);
-            return 1;
-        }
+    if (macro_name->flags & TokenFlag_no_expand) {
+        next_pp_token(pp);
+        return 1;
     }
 
+    if (pp->macros->expansion_recording_depth > 0) {
+        strings_push(&pp->macros->expansion_deps, macro_name->value.string);
+    }
     int macro_idx = find_macro(pp, macro_name->value.string);
     if (macro_idx == -1) {
         next_pp_token(pp);
         return 1;
     }
 
-    SourceLocation original_loc = macro_name->loc;
+    // A macro is not expanded inside its own expansion.
+    if (macros_is_expanding(pp->macros, macro_idx)) {
+        macro_name->flags |= TokenFlag_no_expand;
+        next_pp_token(pp);
+        return 1;
+    }
+
+    SourcePos original_pos = macro_name->pos;
     size_t token_count_before_expansion;
     size_t token_count_after_expansion;
     Macro* macro = &pp->macros->data[macro_idx];
@@ -746,20 +1214,8 @@ static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionConte
         for (size_t i = 0; i < macro->replacements.len; ++i) {
             TokenKind kind = macro->replacements.data[i].kind;
             if (kind == TokenKind_hashhash) {
-                Token* lhs = NULL;
-                for (int j = i - 1; j >= 0; --j) {
-                    if (macro->replacements.data[j].kind != TokenKind_whitespace) {
-                        lhs = &macro->replacements.data[j];
-                        break;
-                    }
-                }
-                Token* rhs = NULL;
-                for (size_t j = i + 1; j < macro->replacements.len; ++j) {
-                    if (macro->replacements.data[j].kind != TokenKind_whitespace) {
-                        rhs = &macro->replacements.data[j];
-                        break;
-                    }
-                }
+                Token* lhs = 0 < i ? &macro->replacements.data[i - 1] : NULL;
+                Token* rhs = i + 1 < macro->replacements.len ? &macro->replacements.data[i + 1] : NULL;
                 if (lhs) {
                     int param1 = macro_find_param(macro, lhs);
                     if (param1 != -1) {
@@ -773,13 +1229,7 @@ static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionConte
                     }
                 }
             } else if (kind == TokenKind_hash) {
-                Token* operand = NULL;
-                for (size_t j = i + 1; j < macro->replacements.len; ++j) {
-                    if (macro->replacements.data[j].kind != TokenKind_whitespace) {
-                        operand = &macro->replacements.data[j];
-                        break;
-                    }
-                }
+                Token* operand = i + 1 < macro->replacements.len ? &macro->replacements.data[i + 1] : NULL;
                 if (operand) {
                     int param = macro_find_param(macro, operand);
                     if (param != -1) {
@@ -794,7 +1244,7 @@ static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionConte
             if (no_expand[i])
                 continue;
             MacroArg* arg = &args->data[i];
-            expand_macro_arg(pp, arg, skip_newline, ctx);
+            expand_macro_arg(pp, arg, skip_newline);
         }
 
         // Parameter substitution
@@ -804,31 +1254,21 @@ static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionConte
             Token* tok = pp_token_at(pp, macro_name_pos + i + offset);
 
             // Handle # operator (stringification)
-            if (tok->kind == TokenKind_hash) {
-                size_t param_idx_in_replacements = 0;
-                for (size_t j = i + 1; j < macro->replacements.len; ++j) {
-                    if (macro->replacements.data[j].kind != TokenKind_whitespace) {
-                        param_idx_in_replacements = j;
-                        break;
-                    }
-                }
-
-                Token* param_tok = &macro->replacements.data[param_idx_in_replacements];
+            if (tok->kind == TokenKind_hash && i + 1 < macro->replacements.len) {
+                Token* param_tok = &macro->replacements.data[i + 1];
                 int macro_param_idx = macro_find_param(macro, param_tok);
                 if (macro_param_idx != -1) {
                     Token* stringified = stringify_tokens(&args->data[macro_param_idx].tokens);
 
-                    // Replace ('#' <whitespace>* <param>) with stringified token.
+                    // Replace ('#' <param>) with stringified token.
                     TokenArray single_token;
                     tokens_init(&single_token, 1);
                     *tokens_push_new(&single_token) = *stringified;
 
-                    size_t tokens_to_replace = param_idx_in_replacements - i + 1;
-                    replace_pp_tokens(pp, macro_name_pos + i + offset, macro_name_pos + i + offset + tokens_to_replace,
-                                      &single_token);
+                    replace_pp_tokens(pp, macro_name_pos + i + offset, macro_name_pos + i + offset + 2, &single_token);
                     token_count += 1;
-                    offset += 1 - tokens_to_replace;
-                    i = param_idx_in_replacements; // Skip to after the parameter
+                    offset -= 1;
+                    i += 1; // Skip to after the parameter
                     continue;
                 }
             }
@@ -842,7 +1282,7 @@ static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionConte
                     tokens_init(&placemarker_token, 1);
                     Token* pm = tokens_push_new(&placemarker_token);
                     pm->kind = TokenKind_placemarker;
-                    pm->loc = tok->loc;
+                    pm->pos = tok->pos;
                     replace_pp_tokens(pp, macro_name_pos + i + offset, macro_name_pos + i + offset + 1,
                                       &placemarker_token);
                     token_count += 1;
@@ -865,22 +1305,10 @@ static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionConte
             Token* tok = pp_token_at(pp, pos);
             if (tok->kind == TokenKind_hashhash) {
                 // Concatenate previous and next tokens
-                int lhs_pos = -1;
-                for (int j = pos - 1; j >= macro_name_pos; --j) {
-                    if (pp_token_at(pp, j)->kind != TokenKind_whitespace) {
-                        lhs_pos = j;
-                        break;
-                    }
-                }
-                int rhs_pos = -1;
-                for (size_t j = pos + 1; j < macro_name_pos + token_count; ++j) {
-                    if (pp_token_at(pp, j)->kind != TokenKind_whitespace) {
-                        rhs_pos = j;
-                        break;
-                    }
-                }
+                int lhs_pos = macro_name_pos < pos ? pos - 1 : -1;
+                int rhs_pos = (size_t)(pos + 1) < macro_name_pos + token_count ? pos + 1 : -1;
                 if (lhs_pos == -1 || rhs_pos == -1) {
-                    fatal_error("%s:%d: invalid usage of ## operator", tok->loc.filename, tok->loc.line);
+                    fatal_error("%s:%d: invalid usage of ## operator", token_filename(tok), token_line(tok));
                 }
 
                 Token* lhs_tok = pp_token_at(pp, lhs_pos);
@@ -895,7 +1323,7 @@ static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionConte
                     // Both are placemarkers: result is a placemarker
                     Token* pm = tokens_push_new(&result_tokens);
                     pm->kind = TokenKind_placemarker;
-                    pm->loc = tok->loc;
+                    pm->pos = tok->pos;
                 } else if (lhs_is_placemarker) {
                     // Left is placemarker: result is the right token
                     *tokens_push_new(&result_tokens) = *rhs_tok;
@@ -927,32 +1355,44 @@ static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionConte
 
         // Inherit a source location from the original macro token.
         for (size_t i = 0; i < token_count2; ++i) {
-            pp_token_at(pp, macro_name_pos + i)->loc = original_loc;
+            pp_token_at(pp, macro_name_pos + i)->pos = original_pos;
         }
         token_count_after_expansion = token_count2;
     } else if (macro->kind == MacroKind_obj) {
+        if (cached_expansion_is_usable(pp->macros, macro)) {
+            pp->pos = replace_pp_tokens(pp, macro_name_pos, macro_name_pos + 1, &macro->cached_expansion);
+            for (size_t i = 0; i < macro->cached_expansion.len; ++i) {
+                pp_token_at(pp, macro_name_pos + i)->pos = original_pos;
+            }
+            if (pp->macros->expansion_recording_depth > 0) {
+                for (size_t i = 0; i < macro->cached_expansion_deps.len; ++i) {
+                    strings_push(&pp->macros->expansion_deps, macro->cached_expansion_deps.data[i]);
+                }
+            }
+            ++macro_table_counters.expansion_cache_hits;
+            pp_report_macro_expansion(macro_idx, macro->name, macro->cached_expansion.len);
+            return 1;
+        }
         replace_pp_tokens(pp, macro_name_pos, macro_name_pos + 1, &macro->replacements);
         // Inherit a source location from the original macro token.
         for (size_t i = 0; i < macro->replacements.len; ++i) {
-            pp_token_at(pp, macro_name_pos + i)->loc = original_loc;
+            pp_token_at(pp, macro_name_pos + i)->pos = original_pos;
         }
         token_count_before_expansion = 1;
         token_count_after_expansion = macro->replacements.len;
     } else if (macro->kind == MacroKind_builtin_file) {
         Token file_tok;
         file_tok.kind = TokenKind_literal_str;
-        file_tok.value.string = macro_name->loc.filename;
-        file_tok.loc.filename = NULL;
-        file_tok.loc.line = 0;
+        file_tok.value.string = token_filename(macro_name);
+        file_tok.pos = 0;
         replace_single_pp_token(pp, macro_name_pos, &file_tok);
         token_count_before_expansion = 1;
         token_count_after_expansion = 1;
     } else if (macro->kind == MacroKind_builtin_line) {
         Token line_tok;
         line_tok.kind = TokenKind_literal_int;
-        line_tok.value.integer = macro_name->loc.line;
-        line_tok.loc.filename = NULL;
-        line_tok.loc.line = 0;
+        line_tok.value.integer = token_line(macro_name);
+        line_tok.pos = 0;
         replace_single_pp_token(pp, macro_name_pos, &line_tok);
         token_count_before_expansion = 1;
         token_count_after_expansion = 1;
@@ -961,18 +1401,31 @@ static int expand_macro(Preprocessor* pp, bool skip_newline, MacroExpansionConte
     }
 
     // Recursive expansion.
-    strings_push(&ctx->already_expanded, macro_name_str);
+    bool is_obj = macro->kind == MacroKind_obj;
+    size_t deps_start = pp->macros->expansion_deps.len;
+    if (is_obj) {
+        ++pp->macros->expansion_recording_depth;
+    }
+    macros_set_expanding(pp->macros, macro_idx, true);
     pp->pos = macro_name_pos;
     size_t processed_token_count = 0;
     while (processed_token_count < token_count_after_expansion) {
         if (peek_pp_token(pp)->kind == TokenKind_ident) {
-            processed_token_count += expand_macro(pp, skip_newline, ctx);
+            processed_token_count += expand_macro(pp, skip_newline);
         } else {
             next_pp_token(pp);
             processed_token_count += 1;
         }
     }
-    strings_pop(&ctx->already_expanded);
+    // Unless the rescan took tokens from after the expansion, as the arguments of a function-like macro.
+    if (is_obj && processed_token_count == token_count_after_expansion) {
+        cache_expansion(pp, macro_idx, macro_name_pos, pp->pos, deps_start);
+    }
+    macros_set_expanding(pp->macros, macro_idx, false);
+    if (is_obj && --pp->macros->expansion_recording_depth == 0) {
+        pp->macros->expansion_deps.len = 0;
+    }
+    pp_report_macro_expansion(macro_idx, pp->macros->data[macro_idx].name, pp->pos - macro_name_pos);
 
     return token_count_before_expansion;
 }
@@ -1000,90 +1453,544 @@ static bool is_delimiter_of_current_group(GroupDelimiterKind delimiter_kind, Tok
 static int replace_pp_tokens(Preprocessor*, int, int, TokenArray*);
 static void include_conditionally(Preprocessor* pp, GroupDelimiterKind delimiter_kind, bool do_include);
 
+// Evaluates the controlling expression of #if and #elif, or the limit of #embed, directly on the preprocessing tokens
+// in [pos, end), after `defined`, `__has_include` and the macros in it have been replaced. Values are computed in
+// `long`, which is intmax_t on every target ducc supports. Operands that are not evaluated, such as the right operand
+// of `0 && x`, are parsed but never fail.
+typedef struct {
+    Preprocessor* pp;
+    int pos;
+    int end;
+    Token directive;
+} PpExprEvaluator;
+
+static Token* pp_expr_peek(PpExprEvaluator* e) {
+    while (e->pos < e->end) {
+        Token* tok = pp_token_at(e->pp, e->pos);
+        if (tok->kind != TokenKind_removed) {
+            return tok;
+        }
+        ++e->pos;
+    }
+    return NULL;
+}
+
+static TokenKind pp_expr_peek_kind(PpExprEvaluator* e) {
+    Token* tok = pp_expr_peek(e);
+    return tok ? tok->kind : TokenKind_newline;
+}
+
+_Noreturn static void pp_expr_unexpected(PpExprEvaluator* e) {
+    Token* tok = pp_expr_peek(e);
+    if (!tok) {
+        fatal_error("%s:%d: unexpected end of %s expression", token_filename(&e->directive),
+                    token_line(&e->directive), token_stringify(&e->directive));
+    }
+    fatal_error("%s:%d: unexpected '%s' in %s expression", token_filename(tok), token_line(tok),
+                token_stringify(tok), token_stringify(&e->directive));
+}
+
+static void pp_expr_expect(PpExprEvaluator* e, TokenKind expected) {
+    if (pp_expr_peek_kind(e) != expected) {
+        pp_expr_unexpected(e);
+    }
+    ++e->pos;
+}
+
+static long pp_eval_conditional_expr(PpExprEvaluator* e, bool evaluated);
+
+// primary-expr:
+//     integer-constant
+//     ( 'L' | 'u' | 'U' | 'u8' )? character-constant
+//     identifier
+//     '(' conditional-expr ')'
+static long pp_eval_primary_expr(PpExprEvaluator* e, bool evaluated) {
+    Token* tok = pp_expr_peek(e);
+    TokenKind k = tok ? tok->kind : TokenKind_newline;
+    if (k == TokenKind_literal_int) {
+        ++e->pos;
+        return tok->value.integer;
+    } else if (k == TokenKind_character_constant) {
+        ++e->pos;
+        return character_constant_value(tok->value.string);
+    } else if (k == TokenKind_ident) {
+        ++e->pos;
+        // The lexer does not know about encoding prefixes, so L'x' is an identifier followed by a character constant.
+        const char* name = tok->value.string;
+        bool is_encoding_prefix = strcmp(name, "L") == 0 || strcmp(name, "u") == 0 || strcmp(name, "U") == 0 ||
+                                  strcmp(name, "u8") == 0;
+        Token* next = pp_expr_peek(e);
+        if (is_encoding_prefix && next && next->kind == TokenKind_character_constant &&
+            !(next->flags & TokenFlag_leading_space)) {
+            ++e->pos;
+            return character_constant_value(next->value.string);
+        }
+        // All remaining identifiers other than true (including those lexically identical to keywords such as false)
+        // are replaced with the pp-number 0, and true is replaced with pp-number 1.
+        return atom_keyword_kind(name) == TokenKind_keyword_true;
+    } else if (k == TokenKind_paren_l) {
+        ++e->pos;
+        long value = pp_eval_conditional_expr(e, evaluated);
+        pp_expr_expect(e, TokenKind_paren_r);
+        return value;
+    } else {
+        pp_expr_unexpected(e);
+    }
+}
+
+// unary-expr:
+//     primary-expr
+//     ( '+' | '-' | '~' | '!' ) unary-expr
+static long pp_eval_unary_expr(PpExprEvaluator* e, bool evaluated) {
+    TokenKind k = pp_expr_peek_kind(e);
+    if (k == TokenKind_plus || k == TokenKind_minus || k == TokenKind_tilde || k == TokenKind_not) {
+        ++e->pos;
+        long operand = pp_eval_unary_expr(e, evaluated);
+        if (k == TokenKind_plus) {
+            return operand;
+        } else if (k == TokenKind_minus) {
+            // In unsigned arithmetic, so that negating LONG_MIN wraps around instead of overflowing.
+            unsigned long negated = operand;
+            negated = -negated;
+            return negated;
+        } else if (k == TokenKind_tilde) {
+            return ~operand;
+        } else {
+            return !operand;
+        }
+    }
+    return pp_eval_primary_expr(e, evaluated);
+}
+
+// Returns the precedence of a binary operator, from 1 for '||' to 10 for '*', or 0 if k is not one.
+static int pp_binary_op_precedence(TokenKind k) {
+    if (k == TokenKind_oror) {
+        return 1;
+    } else if (k == TokenKind_andand) {
+        return 2;
+    } else if (k == TokenKind_or) {
+        return 3;
+    } else if (k == TokenKind_xor) {
+        return 4;
+    } else if (k == TokenKind_and) {
+        return 5;
+    } else if (k == TokenKind_eq || k == TokenKind_ne) {
+        return 6;
+    } else if (k == TokenKind_lt || k == TokenKind_le || k == TokenKind_gt || k == TokenKind_ge) {
+        return 7;
+    } else if (k == TokenKind_lshift || k == TokenKind_rshift) {
+        return 8;
+    } else if (k == TokenKind_plus || k == TokenKind_minus) {
+        return 9;
+    } else if (k == TokenKind_star || k == TokenKind_slash || k == TokenKind_percent) {
+        return 10;
+    } else {
+        return 0;
+    }
+}
+
+static long pp_eval_binary_op(PpExprEvaluator* e, Token* op, long lhs, long rhs, bool evaluated) {
+    TokenKind k = op->kind;
+    if (k == TokenKind_oror) {
+        return lhs || rhs;
+    } else if (k == TokenKind_andand) {
+        return lhs && rhs;
+    } else if (k == TokenKind_or) {
+        return lhs | rhs;
+    } else if (k == TokenKind_xor) {
+        return lhs ^ rhs;
+    } else if (k == TokenKind_and) {
+        return lhs & rhs;
+    } else if (k == TokenKind_eq) {
+        return lhs == rhs;
+    } else if (k == TokenKind_ne) {
+        return lhs != rhs;
+    } else if (k == TokenKind_lt) {
+        return lhs < rhs;
+    } else if (k == TokenKind_le) {
+        return lhs <= rhs;
+    } else if (k == TokenKind_gt) {
+        return lhs > rhs;
+    } else if (k == TokenKind_ge) {
+        return lhs >= rhs;
+    }
+
+    // Overflow and shifting a negative value are undefined for signed operands. The results are meant to wrap around,
+    // so +, -, * and << are computed unsigned.
+    unsigned long a = lhs;
+    unsigned long b = rhs;
+    unsigned long result;
+    if (k == TokenKind_plus) {
+        result = a + b;
+        return result;
+    } else if (k == TokenKind_minus) {
+        result = a - b;
+        return result;
+    } else if (k == TokenKind_star) {
+        result = a * b;
+        return result;
+    }
+
+    // The remaining operators are undefined for some operands, which is only an error if they are evaluated.
+    if (k == TokenKind_lshift || k == TokenKind_rshift) {
+        if (rhs < 0 || rhs >= (long)sizeof(long) * CHAR_BIT) {
+            if (evaluated) {
+                fatal_error("%s:%d: invalid shift count in %s expression", token_filename(op), token_line(op),
+                            token_stringify(&e->directive));
+            }
+            return 0;
+        }
+        if (k == TokenKind_rshift) {
+            return lhs >> rhs;
+        }
+        result = a << rhs;
+        return result;
+    } else {
+        if (rhs == 0) {
+            if (evaluated) {
+                fatal_error("%s:%d: division by zero in %s expression", token_filename(op), token_line(op),
+                            token_stringify(&e->directive));
+            }
+            return 0;
+        }
+        if (rhs == -1) {
+            // Avoid trapping on LONG_MIN / -1.
+            if (k == TokenKind_percent) {
+                return 0;
+            }
+            result = -a;
+            return result;
+        }
+        return k == TokenKind_slash ? lhs / rhs : lhs % rhs;
+    }
+}
+
+// binary-expr:
+//     unary-expr ( binary-op binary-expr )*
+//
+// Operators are parsed by precedence climbing: only those binding at least as tightly as min_precedence are consumed
+// here. All of them are left-associative.
+static long pp_eval_binary_expr(PpExprEvaluator* e, int min_precedence, bool evaluated) {
+    long lhs = pp_eval_unary_expr(e, evaluated);
+    while (true) {
+        Token* op = pp_expr_peek(e);
+        int precedence = op ? pp_binary_op_precedence(op->kind) : 0;
+        if (precedence == 0 || precedence < min_precedence) {
+            break;
+        }
+        ++e->pos;
+        bool rhs_evaluated = evaluated;
+        if (op->kind == TokenKind_andand) {
+            rhs_evaluated = evaluated && lhs;
+        } else if (op->kind == TokenKind_oror) {
+            rhs_evaluated = evaluated && !lhs;
+        }
+        long rhs = pp_eval_binary_expr(e, precedence + 1, rhs_evaluated);
+        lhs = pp_eval_binary_op(e, op, lhs, rhs, evaluated);
+    }
+    return lhs;
+}
+
+// conditional-expr:
+//     binary-expr ( '?' conditional-expr ':' conditional-expr )?
+static long pp_eval_conditional_expr(PpExprEvaluator* e, bool evaluated) {
+    long cond = pp_eval_binary_expr(e, 1, evaluated);
+    if (pp_expr_peek_kind(e) != TokenKind_question) {
+        return cond;
+    }
+    ++e->pos;
+    long then = pp_eval_conditional_expr(e, evaluated && cond);
+    pp_expr_expect(e, TokenKind_colon);
+    long else_ = pp_eval_conditional_expr(e, evaluated && !cond);
+    return cond ? then : else_;
+}
+
+static long pp_eval_expr(Preprocessor* pp, Token* directive, int start, int end) {
+    PpExprEvaluator e;
+    e.pp = pp;
+    e.pos = start;
+    e.end = end;
+    e.directive = *directive;
+    long value = pp_eval_conditional_expr(&e, true);
+    if (pp_expr_peek(&e)) {
+        pp_expr_unexpected(&e);
+    }
+    return value;
+}
+
+// The embed parameters of #embed and __has_embed.
+typedef struct {
+    // -1 if there is no limit.
+    long limit;
+    TokenArray prefix;
+    TokenArray suffix;
+    TokenArray if_empty;
+    // A parameter other than the standard ones was given. __has_embed then reports the resource as not found.
+    const char* unsupported;
+} EmbedParameters;
+
+// Whether the parameters have ended: at the end of the line for #embed, or at the ')' that closes __has_embed.
+static bool pp_at_embed_parameters_end(Preprocessor* pp, bool in_has_embed) {
+    return pp_at_line_end(pp) || (in_has_embed && peek_pp_token(pp)->kind == TokenKind_paren_r);
+}
+
+static Token* expect_pp_token_on_line(Preprocessor* pp, Token* directive, TokenKind expected) {
+    if (pp_at_line_end(pp)) {
+        fatal_error("%s:%d: expected '%s', but got '%s'", token_filename(directive), token_line(directive),
+                    token_kind_stringify(expected), token_kind_stringify(TokenKind_newline));
+    }
+    return expect_pp_token(pp, expected);
+}
+
+// pp-balanced-token-sequence:
+//     pp-balanced-token+
+//
+// Reads the tokens up to the ')' that matches an already consumed '(' into `tokens`, if given.
+static void read_pp_balanced_tokens(Preprocessor* pp, Token* directive, TokenArray* tokens) {
+    int depth = 0;
+    while (true) {
+        if (pp_at_line_end(pp)) {
+            fatal_error("%s:%d: expected '%s', but got '%s'", token_filename(directive), token_line(directive),
+                        token_kind_stringify(TokenKind_paren_r), token_kind_stringify(TokenKind_newline));
+        }
+        Token* tok = peek_pp_token(pp);
+        if (tok->kind == TokenKind_paren_r && depth == 0) {
+            break;
+        }
+        if (tok->kind == TokenKind_paren_l || tok->kind == TokenKind_bracket_l || tok->kind == TokenKind_brace_l) {
+            ++depth;
+        } else if (tok->kind == TokenKind_paren_r || tok->kind == TokenKind_bracket_r ||
+                   tok->kind == TokenKind_brace_r) {
+            --depth;
+        }
+        if (tokens) {
+            *tokens_push_new(tokens) = *tok;
+        }
+        next_pp_token(pp);
+    }
+}
+
+// embed-parameter-sequence:
+//     embed-parameter+
+//
+// embed-parameter:
+//     ( identifier | identifier '::' identifier ) ( '(' pp-balanced-token-sequence? ')' )?
+//
+// Standard parameters may also be spelled __name__. The operand of limit is a constant expression, after macro
+// replacement.
+static void parse_embed_parameters(Preprocessor* pp, Token* directive, bool in_has_embed, EmbedParameters* params) {
+    params->limit = -1;
+    tokens_init(&params->prefix, 1);
+    tokens_init(&params->suffix, 1);
+    tokens_init(&params->if_empty, 1);
+    params->unsupported = NULL;
+
+    while (!pp_at_embed_parameters_end(pp, in_has_embed)) {
+        Token* name_tok = expect_pp_token(pp, TokenKind_ident);
+        const char* name = name_tok->value.string;
+        bool is_vendor = false;
+        if (!pp_at_line_end(pp) && peek_pp_token(pp)->kind == TokenKind_colon) {
+            next_pp_token(pp);
+            expect_pp_token_on_line(pp, directive, TokenKind_colon);
+            Token* vendor_name_tok = expect_pp_token_on_line(pp, directive, TokenKind_ident);
+            StrBuilder builder;
+            strbuilder_init(&builder);
+            strbuilder_append_string(&builder, name);
+            strbuilder_append_string(&builder, "::");
+            strbuilder_append_string(&builder, vendor_name_tok->value.string);
+            name = builder.buf;
+            is_vendor = true;
+        }
+        size_t name_len = strlen(name);
+        if (!is_vendor && 4 < name_len && str_starts_with(name, "__") && str_ends_with(name, "__")) {
+            name = atom_intern(name + 2, name_len - 4);
+        }
+
+        TokenArray* tokens = NULL;
+        if (is_vendor) {
+            params->unsupported = name;
+        } else if (strcmp(name, "limit") == 0) {
+            expect_pp_token_on_line(pp, directive, TokenKind_paren_l);
+            int start = pp->pos;
+            int depth = 0;
+            while (true) {
+                if (pp_at_line_end(pp)) {
+                    fatal_error("%s:%d: expected '%s', but got '%s'", token_filename(directive),
+                                token_line(directive), token_kind_stringify(TokenKind_paren_r),
+                                token_kind_stringify(TokenKind_newline));
+                }
+                Token* tok = peek_pp_token(pp);
+                if (tok->kind == TokenKind_paren_r && depth == 0) {
+                    break;
+                }
+                if (tok->kind == TokenKind_ident) {
+                    expand_macro(pp, false);
+                    continue;
+                }
+                if (tok->kind == TokenKind_paren_l) {
+                    ++depth;
+                } else if (tok->kind == TokenKind_paren_r) {
+                    --depth;
+                }
+                next_pp_token(pp);
+            }
+            params->limit = pp_eval_expr(pp, directive, start, pp->pos);
+            if (params->limit < 0) {
+                fatal_error("%s:%d: negative limit in %s", token_filename(directive), token_line(directive),
+                            token_stringify(directive));
+            }
+            next_pp_token(pp);
+            continue;
+        } else if (strcmp(name, "prefix") == 0) {
+            tokens = &params->prefix;
+        } else if (strcmp(name, "suffix") == 0) {
+            tokens = &params->suffix;
+        } else if (strcmp(name, "if_empty") == 0) {
+            tokens = &params->if_empty;
+        } else {
+            params->unsupported = name;
+        }
+
+        if (tokens) {
+            expect_pp_token_on_line(pp, directive, TokenKind_paren_l);
+        } else if (pp_at_line_end(pp) || !consume_pp_token_if(pp, TokenKind_paren_l)) {
+            continue;
+        }
+        read_pp_balanced_tokens(pp, directive, tokens);
+        next_pp_token(pp);
+    }
+}
+
+// A "..." resource that is not next to the current file is also searched for in the include paths.
+static const char* resolve_embed_name(Preprocessor* pp, const Token* name_tok) {
+    const char* path = resolve_include_name(pp, name_tok);
+    if (name_tok->value.string[0] == '"' && !infile_exists(path)) {
+        search_include_paths(pp, name_tok->value.string, 0, &path);
+    }
+    if (path && (infile_is_builtin(path) || !infile_exists(path))) {
+        return NULL;
+    }
+    return path;
+}
+
+// Maps the resource at `path` and returns how much of it is embedded, or NULL if it cannot be read.
+static EmbeddedData* load_embedded_data(const char* path, long limit) {
+    size_t size;
+    const char* data = file_map_contents(path, &size);
+    if (!data) {
+        return NULL;
+    }
+    EmbeddedData* embedded = arena_alloc(&token_arena, sizeof(EmbeddedData));
+    embedded->data = data;
+    embedded->len = 0 <= limit && (size_t)limit < size ? (size_t)limit : size;
+    return embedded;
+}
+
 static bool preprocess_if_group_or_elif_group(Preprocessor* pp, bool did_include) {
     Token* directive = next_pp_token(pp);
 
     if (directive->kind == TokenKind_pp_directive_if || directive->kind == TokenKind_pp_directive_elif) {
+        // Expanding macros in the condition may move the tokens.
+        Token directive_tok = *directive;
         int condition_expr_start_pos = pp->pos;
 
-        while (!pp_eof(pp)) {
+        while (!pp_at_line_end(pp)) {
             Token* tok = peek_pp_token(pp);
-            if (tok->kind == TokenKind_newline) {
-                break;
-            } else if (tok->kind == TokenKind_ident) {
-                if (strcmp(tok->value.string, "defined") == 0) {
+            if (tok->kind == TokenKind_ident) {
+                if (atom_id(tok->value.string) == Atom_defined) {
                     int defined_pos = pp->pos;
-                    // 'defined' <ws>* '(' <ws>* <ident> <ws>* ')'
-                    // 'defined' <ws>* <ident>
+                    // 'defined' '(' <ident> ')'
+                    // 'defined' <ident>
                     skip_pp_token(pp, TokenKind_ident);
-                    skip_whitespaces(pp);
-                    Token* macro_name;
+                    const char* macro_name;
                     if (consume_pp_token_if(pp, TokenKind_paren_l)) {
-                        skip_whitespaces(pp);
-                        macro_name = expect_pp_token(pp, TokenKind_ident);
-                        skip_whitespaces(pp);
+                        macro_name = expect_pp_token(pp, TokenKind_ident)->value.string;
                         expect_pp_token(pp, TokenKind_paren_r);
                     } else {
-                        macro_name = expect_pp_token(pp, TokenKind_ident);
+                        macro_name = expect_pp_token(pp, TokenKind_ident)->value.string;
+                    }
+                    bool is_defined = is_macro_defined(pp, macro_name);
+                    pp->pos = replace_pp_tokens_with_int(pp, defined_pos, pp->pos, is_defined);
+                } else if (atom_id(tok->value.string) == Atom___has_include) {
+                    int has_include_pos = pp->pos;
+                    // '__has_include' '(' <header-name> ')'
+                    skip_pp_token(pp, TokenKind_ident);
+                    expect_pp_token(pp, TokenKind_paren_l);
+                    // Lex the operand as a header name, as after #include, unless it has been lexed already.
+                    if (pp->lexer && pp->pos == pp_tokens_len(pp)) {
+                        pp->lexer->expect_header_name = true;
+                    }
+                    Token include_name = *next_pp_token(pp);
+                    if (include_name.kind == TokenKind_literal_str) {
+                        char* buf = calloc(strlen(include_name.value.string) + 3, sizeof(char));
+                        sprintf(buf, "\"%s\"", include_name.value.string);
+                        include_name.kind = TokenKind_header_name;
+                        include_name.value.string = buf;
+                    } else if (include_name.kind != TokenKind_header_name) {
+                        fatal_error("%s:%d: invalid __has_include, %s", token_filename(&include_name),
+                                    token_line(&include_name), token_stringify(&include_name));
                     }
-                    bool is_defined = find_macro(pp, macro_name->value.string) != -1;
-                    TokenArray defined_results;
-                    tokens_init(&defined_results, 1);
-                    Token* defined_result = tokens_push_new(&defined_results);
-                    defined_result->kind = TokenKind_literal_int;
-                    defined_result->value.integer = is_defined;
-                    pp->pos = replace_pp_tokens(pp, defined_pos, pp->pos, &defined_results);
+                    expect_pp_token(pp, TokenKind_paren_r);
+                    // A "..." name is resolved without looking at the file system, so whether it exists is left to
+                    // be checked.
+                    const char* path = resolve_include_name(pp, &include_name);
+                    bool has_include = path && (include_name.value.string[0] == '<' || infile_exists(path));
+                    pp->pos = replace_pp_tokens_with_int(pp, has_include_pos, pp->pos, has_include);
+                } else if (atom_id(tok->value.string) == Atom___has_embed) {
+                    int has_embed_pos = pp->pos;
+                    // '__has_embed' '(' <header-name> <embed-parameter-sequence>? ')'
+                    skip_pp_token(pp, TokenKind_ident);
+                    expect_pp_token(pp, TokenKind_paren_l);
+                    if (pp->lexer && pp->pos == pp_tokens_len(pp)) {
+                        pp->lexer->expect_header_name = true;
+                    }
+                    Token resource_name = *next_pp_token(pp);
+                    if (resource_name.kind != TokenKind_header_name) {
+                        fatal_error("%s:%d: invalid __has_embed, %s", token_filename(&resource_name),
+                                    token_line(&resource_name), token_stringify(&resource_name));
+                    }
+                    EmbedParameters params;
+                    parse_embed_parameters(pp, &directive_tok, true, &params);
+                    expect_pp_token(pp, TokenKind_paren_r);
+                    const char* path = resolve_embed_name(pp, &resource_name);
+                    // The resource is not mapped, only checked for contents.
+                    int contents = path && !params.unsupported ? file_probe_contents(path) : -1;
+                    // __STDC_EMBED_NOT_FOUND__, __STDC_EMBED_FOUND__ or __STDC_EMBED_EMPTY__
+                    int has_embed = contents == -1 ? 0 : contents == 0 || params.limit == 0 ? 2 : 1;
+                    pp->pos = replace_pp_tokens_with_int(pp, has_embed_pos, pp->pos, has_embed);
                 } else {
-                    expand_macro(pp, false, NULL);
+                    expand_macro(pp, false);
                 }
             } else {
                 next_pp_token(pp);
             }
         }
 
-        // all remaining identifiers other than true (including those lexically identical to keywords such as false) are
-        // replaced with the pp-number 0, true is replaced with pp-number 1, and then each preprocessing token is
-        // converted into a token.
-        for (int pos = condition_expr_start_pos; pos < pp->pos; ++pos) {
-            Token* tok = pp_token_at(pp, pos);
-            if (tok->kind == TokenKind_ident) {
-                bool is_true = strcmp(tok->value.string, "true") == 0;
-                tok->kind = TokenKind_literal_int;
-                tok->value.integer = is_true;
-            }
-        }
-
-        int condition_expr_tokens_len = pp->pos - condition_expr_start_pos;
-        TokenArray condition_expr_tokens;
-        // +1 to add EOF token at the end.
-        tokens_init(&condition_expr_tokens, condition_expr_tokens_len + 1);
-        for (int i = 0; i < condition_expr_tokens_len; ++i) {
-            *tokens_push_new(&condition_expr_tokens) = *pp_token_at(pp, condition_expr_start_pos + i);
-        }
-        Token* eof_tok = tokens_push_new(&condition_expr_tokens);
-        eof_tok->kind = TokenKind_eof;
-
-        bool do_include = pp_eval_constant_expr(&condition_expr_tokens) && !did_include;
+        int condition_expr_end_pos = pp->pos;
+        bool do_include =
+            pp_eval_expr(pp, &directive_tok, condition_expr_start_pos, condition_expr_end_pos) != 0 && !did_include;
         include_conditionally(pp, GroupDelimiterKind_after_if_directive, do_include);
         return do_include;
     } else if (directive->kind == TokenKind_pp_directive_ifdef || directive->kind == TokenKind_pp_directive_elifdef) {
-        skip_whitespaces(pp);
         Token* macro_name = consume_pp_token_if(pp, TokenKind_ident);
         if (!macro_name) {
             fatal_error("");
         }
+        const char* macro_name_str = macro_name->value.string;
+        seek_to_next_line(pp);
 
-        bool do_include = !did_include && find_macro(pp, macro_name->value.string) != -1;
+        bool do_include = !did_include && is_macro_defined(pp, macro_name_str);
         include_conditionally(pp, GroupDelimiterKind_after_if_directive, do_include);
         return do_include;
     } else if (directive->kind == TokenKind_pp_directive_ifndef || directive->kind == TokenKind_pp_directive_elifndef) {
-        skip_whitespaces(pp);
         Token* macro_name = consume_pp_token_if(pp, TokenKind_ident);
         if (!macro_name) {
             fatal_error("");
         }
+        const char* macro_name_str = macro_name->value.string;
+        seek_to_next_line(pp);
 
-        bool do_include = !did_include && find_macro(pp, macro_name->value.string) == -1;
+        bool do_include = !did_include && !is_macro_defined(pp, macro_name_str);
         include_conditionally(pp, GroupDelimiterKind_after_if_directive, do_include);
         return do_include;
     } else {
@@ -1118,9 +2025,6 @@ static bool preprocess_elif_groups_opt(Preprocessor* pp, bool did_include) {
 //     '#' 'else' group?
 static void preprocess_else_group(Preprocessor* pp, bool did_include) {
     skip_pp_token(pp, TokenKind_pp_directive_else);
-    skip_whitespaces(pp);
-    expect_pp_token(pp, TokenKind_newline);
-
     include_conditionally(pp, GroupDelimiterKind_after_else_directive, !did_include);
 }
 
@@ -1128,138 +2032,163 @@ static void preprocess_else_group(Preprocessor* pp, bool did_include) {
 //     '#' 'endif' new-line
 static void preprocess_endif_directive(Preprocessor* pp) {
     skip_pp_token(pp, TokenKind_pp_directive_endif);
-    skip_whitespaces(pp);
-    expect_pp_token(pp, TokenKind_newline);
+    expect_pp_newline(pp);
 }
 
 // if-section:
 //     if-group elif-groups? else-group? endif-line
-static void preprocess_if_section(Preprocessor* pp) {
+//
+// Returns true if the section consists of the if-group only.
+static bool preprocess_if_section(Preprocessor* pp) {
     bool did_include = preprocess_if_group(pp);
+    bool if_group_only = peek_pp_token(pp)->kind == TokenKind_pp_directive_endif;
     did_include = preprocess_elif_groups_opt(pp, did_include);
     if (peek_pp_token(pp)->kind == TokenKind_pp_directive_else) {
         preprocess_else_group(pp, did_include);
     }
     preprocess_endif_directive(pp);
+    return if_group_only;
+}
+
+// Records a file for -M, -MM, -MD and -MMD, which list system headers too or only user headers.
+static void add_included_file(Preprocessor* pp, const Token* include_name, const char* path) {
+    if ((pp->generate_system_deps && include_name->value.string[0] == '<') ||
+        (pp->generate_user_deps && include_name->value.string[0] == '"')) {
+        record_included_file(pp->included_files, path);
+    }
 }
 
 static void preprocess_include_directive(Preprocessor* pp) {
     skip_pp_token(pp, TokenKind_pp_directive_include);
-    skip_whitespaces(pp);
-    Token* include_name = read_include_header_name(pp);
+    Token include_name_tok = *read_include_header_name(pp);
+    Token* include_name = &include_name_tok;
     const char* include_name_resolved = resolve_include_name(pp, include_name);
     if (include_name_resolved == NULL) {
-        fatal_error("%s:%d: cannot resolve include file name: %s", include_name->loc.filename, include_name->loc.line,
-                    token_stringify(include_name));
+        fatal_error("%s:%d: cannot resolve include file name: %s", token_filename(include_name),
+                    token_line(include_name), token_stringify(include_name));
     }
 
-    if ((pp->generate_system_deps && include_name->value.string[0] == '<') ||
-        (pp->generate_user_deps && include_name->value.string[0] == '"')) {
-        bool already_included = false;
-        for (size_t i = 0; i < pp->included_files->len; ++i) {
-            if (strcmp(pp->included_files->data[i], include_name_resolved) == 0) {
-                already_included = true;
-                break;
-            }
-        }
-        if (!already_included) {
-            strings_push(pp->included_files, include_name_resolved);
-        }
-    }
+    add_included_file(pp, include_name, include_name_resolved);
 
-    skip_whitespaces(pp);
-    expect_pp_token(pp, TokenKind_newline);
-    expand_include_directive(pp, include_name_resolved, include_name);
+    expect_pp_newline(pp);
+    expand_include_directive(pp, include_name_resolved, &include_name_tok);
 }
 
 // #include_next is a part of GNU extension.
 // https://gcc.gnu.org/onlinedocs/cpp/Wrapper-Headers.html
 static void preprocess_include_next_directive(Preprocessor* pp) {
     skip_pp_token(pp, TokenKind_pp_directive_include_next);
-    skip_whitespaces(pp);
-    Token* include_name = read_include_header_name(pp);
+    Token include_name_tok = *read_include_header_name(pp);
+    Token* include_name = &include_name_tok;
     const char* include_name_resolved = resolve_next_include_name(pp, include_name);
     if (include_name_resolved == NULL) {
-        fatal_error("%s:%d: cannot resolve include file name: %s", include_name->loc.filename, include_name->loc.line,
-                    token_stringify(include_name));
+        fatal_error("%s:%d: cannot resolve include file name: %s", token_filename(include_name),
+                    token_line(include_name), token_stringify(include_name));
     }
 
-    if (include_name->value.string[0] == '"') {
-        bool already_included = false;
-        for (size_t i = 0; i < pp->included_files->len; ++i) {
-            if (strcmp(pp->included_files->data[i], include_name_resolved) == 0) {
-                already_included = true;
-                break;
-            }
+    add_included_file(pp, include_name, include_name_resolved);
+
+    expect_pp_newline(pp);
+    expand_include_directive(pp, include_name_resolved, &include_name_tok);
+}
+
+// embed-line:
+//     '#' 'embed' header-name embed-parameter-sequence? new-line
+//
+// The directive is replaced by the prefix, the data and the suffix, or by if_empty if there is no data. The data is one
+// token, which the parser takes as a whole where it makes up elements of a braced initializer.
+static void preprocess_embed_directive(Preprocessor* pp) {
+    Token directive = *next_pp_token(pp);
+    Token resource_name = *next_pp_token(pp);
+    if (resource_name.kind != TokenKind_header_name) {
+        fatal_error("%s:%d: invalid #embed, %s", token_filename(&resource_name), token_line(&resource_name),
+                    token_stringify(&resource_name));
+    }
+    EmbedParameters params;
+    parse_embed_parameters(pp, &directive, false, &params);
+    if (params.unsupported) {
+        fatal_error("%s:%d: unsupported #embed parameter: %s", token_filename(&directive), token_line(&directive),
+                    params.unsupported);
+    }
+    expect_pp_newline(pp);
+
+    const char* path = resolve_embed_name(pp, &resource_name);
+    EmbeddedData* embedded = path ? load_embedded_data(path, params.limit) : NULL;
+    if (!embedded) {
+        fatal_error("%s:%d: cannot open embed resource: %s", token_filename(&resource_name),
+                    token_line(&resource_name), token_stringify(&resource_name));
+    }
+    add_included_file(pp, &resource_name, path);
+
+    TokenArray tokens;
+    tokens_init(&tokens, params.prefix.len + 1 + params.suffix.len);
+    if (embedded->len == 0) {
+        for (size_t i = 0; i < params.if_empty.len; ++i) {
+            *tokens_push_new(&tokens) = params.if_empty.data[i];
+        }
+    } else {
+        for (size_t i = 0; i < params.prefix.len; ++i) {
+            *tokens_push_new(&tokens) = params.prefix.data[i];
         }
-        if (!already_included) {
-            strings_push(pp->included_files, include_name_resolved);
+        Token* data_tok = tokens_push_new(&tokens);
+        data_tok->kind = TokenKind_embedded_data;
+        data_tok->value.embedded_data = embedded;
+        data_tok->pos = directive.pos;
+        for (size_t i = 0; i < params.suffix.len; ++i) {
+            *tokens_push_new(&tokens) = params.suffix.data[i];
         }
     }
+    if (tokens.len == 0) {
+        return;
+    }
 
-    skip_whitespaces(pp);
-    expect_pp_token(pp, TokenKind_newline);
-    expand_include_directive(pp, include_name_resolved, include_name);
-}
-
-static void preprocess_embed_directive(Preprocessor*) {
-    unimplemented();
+    // The tokens go on a line of their own after the directive, so that they are processed as a text line and not
+    // removed with the directive.
+    tokens.data[0].flags |= TokenFlag_at_bol;
+    tokens.data[0].newlines = 0;
+    replace_pp_tokens(pp, pp->pos, pp->pos, &tokens);
+    // -E writes them on the line of the directive, so the new-line that ends it goes back after them.
+    Token* next = pp_token_at(pp, pp->pos + tokens.len);
+    if (next->newlines < CHAR_MAX) {
+        ++next->newlines;
+    }
 }
 
 static void preprocess_define_directive(Preprocessor* pp) {
     skip_pp_token(pp, TokenKind_pp_directive_define);
-    skip_whitespaces(pp);
-    Token* macro_name = expect_pp_token(pp, TokenKind_ident);
+    const char* macro_name = expect_pp_token(pp, TokenKind_ident)->value.string;
 
-    if (consume_pp_token_if(pp, TokenKind_paren_l)) {
+    // A macro is function-like only if '(' immediately follows its name.
+    Token* paren = peek_pp_token(pp);
+    if (paren->kind == TokenKind_paren_l && !(paren->flags & TokenFlag_leading_space)) {
+        next_pp_token(pp);
         TokenArray* parameters = pp_parse_macro_parameters(pp);
-        skip_whitespaces(pp);
         int replacements_start_pos = pp->pos;
-        seek_to_next_newline(pp);
-        Macro* macro = macros_push_new(pp->macros);
+        seek_to_next_line(pp);
+        Macro* macro = macros_define(pp->macros, macro_name);
         macro->kind = MacroKind_func;
-        macro->name = macro_name->value.string;
         macro->parameters = *parameters;
         int n_replacements = pp->pos - replacements_start_pos;
         tokens_init(&macro->replacements, n_replacements);
         for (int i = 0; i < n_replacements; ++i) {
             *tokens_push_new(&macro->replacements) = *pp_token_at(pp, replacements_start_pos + i);
         }
-        // Remove trailing whitespaces.
-        for (int i = n_replacements - 1; i >= 0; --i) {
-            if (macro->replacements.data[i].kind == TokenKind_whitespace) {
-                tokens_pop(&macro->replacements);
-            } else {
-                break;
-            }
-        }
     } else {
-        skip_whitespaces(pp);
         int replacements_start_pos = pp->pos;
-        seek_to_next_newline(pp);
-        Macro* macro = macros_push_new(pp->macros);
+        seek_to_next_line(pp);
+        Macro* macro = macros_define(pp->macros, macro_name);
         macro->kind = MacroKind_obj;
-        macro->name = macro_name->value.string;
         int n_replacements = pp->pos - replacements_start_pos;
         tokens_init(&macro->replacements, n_replacements);
         for (int i = 0; i < n_replacements; ++i) {
             *tokens_push_new(&macro->replacements) = *pp_token_at(pp, replacements_start_pos + i);
         }
-        // Remove trailing whitespaces.
-        for (int i = n_replacements - 1; i >= 0; --i) {
-            if (macro->replacements.data[i].kind == TokenKind_whitespace) {
-                tokens_pop(&macro->replacements);
-            } else {
-                break;
-            }
-        }
     }
-    expect_pp_token(pp, TokenKind_newline);
+    expect_pp_newline(pp);
 }
 
 static void preprocess_undef_directive(Preprocessor* pp) {
     skip_pp_token(pp, TokenKind_pp_directive_undef);
-    skip_whitespaces(pp);
     Token* macro_name = consume_pp_token_if(pp, TokenKind_ident);
     if (macro_name) {
         int macro_idx = find_macro(pp, macro_name->value.string);
@@ -1267,6 +2196,8 @@ static void preprocess_undef_directive(Preprocessor* pp) {
             undef_macro(pp, macro_idx);
         }
     }
+    seek_to_next_line(pp);
+    expect_pp_newline(pp);
 }
 
 static void preprocess_line_directive(Preprocessor*) {
@@ -1281,11 +2212,9 @@ static void preprocess_error_directive(Preprocessor* pp) {
     // Ducc assumes that #error takes exactly one argument consisting of a string literal.
     // TODO: output some general message or something else if not.
     skip_pp_token(pp, TokenKind_pp_directive_error);
-    skip_whitespaces(pp);
-    Token* msg = expect_pp_token(pp, TokenKind_literal_str);
-    skip_whitespaces(pp);
-    expect_pp_token(pp, TokenKind_newline);
-    fatal_error("%s:%d: %s", msg->loc.filename, msg->loc.line, msg->value.string);
+    Token msg = *expect_pp_token(pp, TokenKind_literal_str);
+    expect_pp_newline(pp);
+    fatal_error("%s:%d: %s", token_filename(&msg), token_line(&msg), msg.value.string);
 }
 
 // control-line:
@@ -1296,43 +2225,53 @@ static void preprocess_warning_directive(Preprocessor* pp) {
     // Ducc assumes that #warning takes exactly one argument consisting of a string literal.
     // TODO: output some general message or something else if not.
     skip_pp_token(pp, TokenKind_pp_directive_warning);
-    skip_whitespaces(pp);
-    Token* msg = expect_pp_token(pp, TokenKind_literal_str);
-    skip_whitespaces(pp);
-    expect_pp_token(pp, TokenKind_newline);
-    fprintf(stderr, "%s:%d: %s", msg->loc.filename, msg->loc.line, msg->value.string);
+    Token msg = *expect_pp_token(pp, TokenKind_literal_str);
+    expect_pp_newline(pp);
+    fprintf(stderr, "%s:%d: %s", token_filename(&msg), token_line(&msg), msg.value.string);
 }
 
 static void preprocess_pragma_directive(Preprocessor* pp) {
-    // Ignore all #pragma directives for now.
+    // Other #pragma directives are ignored for now.
     skip_pp_token(pp, TokenKind_pp_directive_pragma);
-    seek_to_next_newline(pp);
-    skip_pp_token(pp, TokenKind_newline);
+    Token* name = peek_pp_token(pp);
+    if (name->kind == TokenKind_ident && strcmp(name->value.string, "once") == 0) {
+        file_guards_get(pp->file_guards, infile_path(pp->lexer->src))->pragma_once = true;
+    }
+    seek_to_next_line(pp);
+    expect_pp_newline(pp);
 }
 
 static void preprocess_nop_directive(Preprocessor* pp) {
     skip_pp_token(pp, TokenKind_pp_directive_nop);
+    expect_pp_newline(pp);
 }
 
 static void preprocess_non_directive_directive(Preprocessor* pp) {
     Token* tok = peek_pp_token(pp);
     // C23 6.10.1.13:
     // The execution of a non-directive preprocessing directive results in undefined behavior.
-    fatal_error("%s:%d: invalid preprocessing directive, '%s'", tok->loc.filename, tok->loc.line, token_stringify(tok));
+    fatal_error("%s:%d: invalid preprocessing directive, '%s'", token_filename(tok), token_line(tok),
+                token_stringify(tok));
 }
 
 static void preprocess_text_line(Preprocessor* pp) {
-    while (!pp_eof(pp)) {
-        if (consume_pp_token_if(pp, TokenKind_newline)) {
+    if (pp->deps_only && pp->lexer) {
+        // Only the directives matter. As for a skipped group, the rest of the text is skipped in the raw source.
+        pp_close_gap(pp);
+        if (pp->pos + 1 == pp_tokens_len(pp)) {
+            tokens_pop(pp->pp_tokens);
+            lexer_skip_to_next_directive(pp->lexer);
             return;
         }
+    }
+
+    do {
         if (consume_pp_token_if_not(pp, TokenKind_ident)) {
             continue;
         }
 
-        expand_macro(pp, true, NULL);
-    }
-    expect_pp_token(pp, TokenKind_newline);
+        expand_macro(pp, true);
+    } while (!pp_at_line_end(pp));
 }
 
 // group-part:
@@ -1359,7 +2298,7 @@ static void preprocess_group_part(Preprocessor* pp) {
     } else if (tok->kind == TokenKind_pp_directive_elif || tok->kind == TokenKind_pp_directive_elifdef ||
                tok->kind == TokenKind_pp_directive_elifndef || tok->kind == TokenKind_pp_directive_else ||
                tok->kind == TokenKind_pp_directive_endif) {
-        fatal_error("%s:%d: unexpected '%s'; no corresponding '#if'*", tok->loc.filename, tok->loc.line,
+        fatal_error("%s:%d: unexpected '%s'; no corresponding '#if'*", token_filename(tok), token_line(tok),
                     token_kind_stringify(tok->kind));
     } else if (tok->kind == TokenKind_pp_directive_include) {
         preprocess_include_directive(pp);
@@ -1403,13 +2342,27 @@ static void preprocess_group_opt(Preprocessor* pp, GroupDelimiterKind delimiter_
     }
 }
 
+// The lines of a skipped group need not be valid C; they may have an unterminated quote, for example. So the group is
+// skipped in the raw text, and only the first token of each directive in it is lexed.
 static void skip_group_opt(Preprocessor* pp, GroupDelimiterKind delimiter_kind) {
     assert(delimiter_kind != GroupDelimiterKind_normal);
     int nesting = 0;
+    SourcePos start_pos;
+    if (pp->lexer && pp->pos == pp_tokens_len(pp) && pp_at_line_end(pp) && !pp->lexer->reached_eof) {
+        // Start skipping before the new-line of the opening directive is consumed, which would lex the next line.
+        start_pos = lexer_skip_to_next_directive(pp->lexer);
+        expect_pp_newline(pp);
+    } else {
+        expect_pp_newline(pp);
+        start_pos = peek_pp_token(pp)->pos;
+    }
 
     while (!pp_eof(pp)) {
         Token* tok = peek_pp_token(pp);
+        // None of the skipped lines are written by -E.
+        tok->newlines = 0;
         if (nesting == 0 && is_delimiter_of_current_group(delimiter_kind, tok->kind)) {
+            pp_report_skipped_group(start_pos, tok->pos);
             return;
         }
         if (tok->kind == TokenKind_pp_directive_if || tok->kind == TokenKind_pp_directive_ifdef ||
@@ -1418,17 +2371,20 @@ static void skip_group_opt(Preprocessor* pp, GroupDelimiterKind delimiter_kind)
         } else if (tok->kind == TokenKind_pp_directive_endif) {
             --nesting;
         }
-        int first_pos = pp->pos;
-        seek_to_next_newline(pp);
-        expect_pp_token(pp, TokenKind_newline);
-        make_tokens_removed(pp, first_pos, pp->pos);
+        // Only the first token of each directive is lexed; the rest of the group is skipped in the raw text.
+        pp_close_gap(pp);
+        assert(pp->pos + 1 == pp_tokens_len(pp));
+        tokens_pop(pp->pp_tokens);
+        lexer_skip_to_next_directive(pp->lexer);
     }
 
     expect_pp_token(pp, TokenKind_pp_directive_endif);
 }
 
+// Ends the directive that opens a group, then preprocesses or skips the group.
 static void include_conditionally(Preprocessor* pp, GroupDelimiterKind delimiter_kind, bool do_include) {
     if (do_include) {
+        expect_pp_newline(pp);
         preprocess_group_opt(pp, delimiter_kind);
     } else {
         skip_group_opt(pp, delimiter_kind);
@@ -1437,57 +2393,420 @@ static void include_conditionally(Preprocessor* pp, GroupDelimiterKind delimiter
 
 // preprocessing-file:
 //     group?
-static void preprocess_preprocessing_file(Preprocessor* pp) {
+//
+// Returns the macro of the file's include guard, or NULL if it has none. A file is guarded by X if it is a single
+// if-section that starts with '#ifndef X' and has neither #elif nor #else, so that it produces nothing while X is
+// defined.
+static const char* preprocess_preprocessing_file(Preprocessor* pp) {
+    Token* tok = peek_pp_token(pp);
+    if (tok->kind != TokenKind_pp_directive_ifndef) {
+        preprocess_group_opt(pp, GroupDelimiterKind_normal);
+        return NULL;
+    }
+
+    const char* guard_macro = NULL;
+    Token* macro_name = pp_token_at(pp, pp->pos + 1);
+    if (macro_name->kind == TokenKind_ident && !(macro_name->flags & TokenFlag_at_bol)) {
+        guard_macro = macro_name->value.string;
+    }
+    if (!preprocess_if_section(pp) || !pp_eof(pp)) {
+        guard_macro = NULL;
+    }
     preprocess_group_opt(pp, GroupDelimiterKind_normal);
+    return guard_macro;
 }
 
+// The directive's new-line has already been taken off by expect_pp_newline().
 static void remove_pp_directive(Preprocessor* pp, int directive_token_pos) {
-    seek_to_next_newline(pp);
-    skip_pp_token(pp, TokenKind_newline);
+    next_pp_token(pp);
+    seek_to_next_line(pp);
     make_tokens_removed(pp, directive_token_pos, pp->pos);
 }
 
-static void remove_pp_directives(Preprocessor* pp) {
-    pp->pos = 0;
-    while (!pp_eof(pp)) {
+// Marks the directive lines in [start, end) as removed. Each file removes its own directives, a part before each
+// #include and the rest at the end, so that tokens of included files are not looked at again.
+static void remove_pp_directives(Preprocessor* pp, int start, int end) {
+    int pos = pp->pos;
+    pp->pos = start;
+    while (pp->pos < end) {
         if (is_pp_directive(peek_pp_token(pp)->kind)) {
             remove_pp_directive(pp, pp->pos);
         } else {
             next_pp_token(pp);
         }
     }
+    pp->pos = pos;
+}
+
+// Preprocesses `src` and appends the resulting tokens to `pp_tokens`, followed by an EOF token.
+static void do_preprocess(TokenArray* pp_tokens, InFile* src, int depth, MacroArray* macros, StrArray* include_paths,
+                          StrArray* included_files, FileGuardArray* file_guards, bool generate_system_deps,
+                          bool generate_user_deps, bool deps_only) {
+    Preprocessor* pp = preprocessor_new(pp_tokens, depth, macros, include_paths, included_files, file_guards,
+                                        generate_system_deps, generate_user_deps, deps_only);
+    pp_report_enter_file(src->filename);
+    pp->lexer = lexer_new(src, pp_tokens);
+    pp->pos = pp_tokens->len;
+    pp->directives_start = pp->pos;
+
+    const char* guard_macro = preprocess_preprocessing_file(pp);
+    if (guard_macro) {
+        file_guards_get(file_guards, infile_path(src))->guard_macro = guard_macro;
+    }
+    pp_close_gap(pp);
+    remove_pp_directives(pp, pp->directives_start, pp->pos);
+    pp_report_leave_file();
+}
+
+// A precompiled header is what preprocessing a header leaves behind: the macro table, the include guards, the list of
+// included files and the tokens. `-x c-header` writes it to a file, and `-include-pch` reads it back instead of
+// preprocessing the header again.
+//
+// The file starts with a table of all the strings, to which the rest refers by index, -1 meaning NULL. Then come the
+// -D and -I options and the opened source files, to check that the state is still valid, followed by the state itself.
+// Integers are stored in the byte order of the machine, and tokens as they are in memory, with a string index in place
+// of a string value; a precompiled header is only meant to be read by the ducc that wrote it, so the header also
+// records DUCC_VERSION.
+struct PrecompiledHeader {
+    MacroArray* macros;
+    FileGuardArray* file_guards;
+    StrArray included_files;
+    TokenArray tokens;
+};
+
+#define PCH_MAGIC "ducc-pch"
+#define PCH_VERSION 2
+
+static bool token_has_string_value(TokenKind k) {
+    return k == TokenKind_other || k == TokenKind_character_constant || k == TokenKind_ident ||
+           k == TokenKind_literal_str || k == TokenKind_header_name || k == TokenKind_pp_directive_non_directive;
+}
+
+typedef struct {
+    StrBuilder strings;
+    int string_count;
+    // Index in the string table by the atom ID of the string, or -1.
+    IntArray string_indices;
+    StrBuilder body;
+} PchWriter;
+
+static void pch_write_int(StrBuilder* b, int value) {
+    strbuilder_append_bytes(b, (const char*)&value, sizeof(int));
+}
+
+static void pch_write_long(StrBuilder* b, long value) {
+    strbuilder_append_bytes(b, (const char*)&value, sizeof(long));
+}
+
+// Strings are interned so that each one is stored once.
+static int pch_string_index(PchWriter* w, const char* s) {
+    if (!s) {
+        return -1;
+    }
+    int id = atom_id(atom_intern_string(s));
+    while (w->string_indices.len <= (size_t)id) {
+        ints_push(&w->string_indices, -1);
+    }
+    if (w->string_indices.data[id] == -1) {
+        int len = strlen(s);
+        pch_write_int(&w->strings, len);
+        strbuilder_append_bytes(&w->strings, s, len + 1);
+        w->string_indices.data[id] = w->string_count++;
+    }
+    return w->string_indices.data[id];
+}
+
+static void pch_write_string(PchWriter* w, const char* s) {
+    pch_write_int(&w->body, pch_string_index(w, s));
+}
+
+static void pch_write_strings(PchWriter* w, StrArray* strings) {
+    pch_write_int(&w->body, strings->len);
+    for (size_t i = 0; i < strings->len; ++i) {
+        pch_write_string(w, strings->data[i]);
+    }
+}
+
+static void pch_write_tokens(PchWriter* w, TokenArray* tokens) {
+    pch_write_int(&w->body, tokens->len);
+    for (size_t i = 0; i < tokens->len; ++i) {
+        // Only the part of the value that the kind uses is written, so that the output does not depend on leftovers.
+        Token tok = tokens->data[i];
+        if (tok.kind == TokenKind_embedded_data) {
+            fatal_error("%s:%d: #embed is not supported in precompiled headers", token_filename(&tok),
+                        token_line(&tok));
+        }
+        TokenValue value = tok.value;
+        memset(&tok.value, 0, sizeof(TokenValue));
+        if (token_has_string_value(tok.kind)) {
+            tok.value.integer = pch_string_index(w, value.string);
+        } else if (tok.kind == TokenKind_literal_int) {
+            tok.value.integer = value.integer;
+        } else if (tok.kind == TokenKind_literal_double) {
+            tok.value = value;
+        }
+        strbuilder_append_bytes(&w->body, (const char*)&tok, sizeof(Token));
+    }
+}
+
+static void write_pch(const char* filename, TokenArray* pp_tokens, MacroArray* macros, FileGuardArray* file_guards,
+                      StrArray* included_files, StrArray* user_defines, StrArray* user_include_dirs) {
+    PchWriter w;
+    strbuilder_init(&w.strings);
+    w.string_count = 0;
+    ints_init(&w.string_indices);
+    strbuilder_init(&w.body);
+
+    pch_write_strings(&w, user_defines);
+    pch_write_strings(&w, user_include_dirs);
+
+    size_t n_files = infile_opened_count();
+    pch_write_int(&w.body, n_files);
+    for (size_t i = 0; i < n_files; ++i) {
+        InFile* f = infile_opened_at(i);
+        pch_write_string(&w, f->filename);
+        pch_write_int(&w.body, f->base);
+        pch_write_long(&w.body, f->text->len);
+        pch_write_long(&w.body, f->text->mtime_sec);
+        pch_write_long(&w.body, f->text->mtime_nsec);
+    }
+
+    pch_write_strings(&w, included_files);
+
+    pch_write_int(&w.body, file_guards->len);
+    for (size_t i = 0; i < file_guards->len; ++i) {
+        FileGuard* guard = &file_guards->data[i];
+        pch_write_string(&w, guard->path);
+        pch_write_string(&w, guard->guard_macro);
+        pch_write_int(&w.body, guard->pragma_once);
+    }
+
+    pch_write_int(&w.body, macros->len);
+    for (size_t i = 0; i < macros->len; ++i) {
+        Macro* m = &macros->data[i];
+        pch_write_string(&w, m->name);
+        pch_write_int(&w.body, m->kind);
+        pch_write_tokens(&w, &m->parameters);
+        pch_write_tokens(&w, &m->replacements);
+    }
+
+    pch_write_tokens(&w, pp_tokens);
+
+    FILE* out = fopen(filename, "wb");
+    if (!out) {
+        fatal_error("cannot open output file: %s", filename);
+    }
+    fwrite(PCH_MAGIC, 1, strlen(PCH_MAGIC), out);
+    StrBuilder header;
+    strbuilder_init(&header);
+    pch_write_int(&header, strlen(DUCC_VERSION));
+    strbuilder_append_bytes(&header, DUCC_VERSION, strlen(DUCC_VERSION));
+    pch_write_int(&header, PCH_VERSION);
+    pch_write_int(&header, sizeof(Token));
+    pch_write_int(&header, w.string_count);
+    fwrite(header.buf, 1, header.len, out);
+    fwrite(w.strings.buf, 1, w.strings.len, out);
+    fwrite(w.body.buf, 1, w.body.len, out);
+    if (fclose(out) != 0) {
+        fatal_error("cannot write precompiled header: %s", filename);
+    }
+}
+
+typedef struct {
+    const char* filename;
+    const char* buf;
+    size_t len;
+    size_t pos;
+    const char** strings;
+    int string_count;
+} PchReader;
+
+static void pch_read_bytes(PchReader* r, void* dest, size_t size) {
+    if (r->len - r->pos < size) {
+        fatal_error("%s: invalid precompiled header", r->filename);
+    }
+    memcpy(dest, r->buf + r->pos, size);
+    r->pos += size;
+}
+
+static int pch_read_int(PchReader* r) {
+    int value;
+    pch_read_bytes(r, &value, sizeof(int));
+    return value;
+}
+
+static long pch_read_long(PchReader* r) {
+    long value;
+    pch_read_bytes(r, &value, sizeof(long));
+    return value;
 }
 
-static char* get_ducc_include_path() {
-    const char* self_dir = get_self_dir();
-    char* buf = calloc(strlen(self_dir) + strlen("/../include") + 1, sizeof(char));
-    sprintf(buf, "%s/../include", self_dir);
-    return buf;
+static const char* pch_read_string(PchReader* r) {
+    int index = pch_read_int(r);
+    if (index < -1 || r->string_count <= index) {
+        fatal_error("%s: invalid precompiled header", r->filename);
+    }
+    return index == -1 ? NULL : r->strings[index];
 }
 
-static TokenArray* do_preprocess(InFile* src, int depth, MacroArray* macros, StrArray* include_paths,
-                                 StrArray* included_files, bool generate_system_deps, bool generate_user_deps) {
-    TokenArray* pp_tokens = tokenize(src);
-    Preprocessor* pp = preprocessor_new(pp_tokens, depth, macros, include_paths, included_files, generate_system_deps,
-                                        generate_user_deps);
+// Whether the header was written by this version of ducc.
+static bool pch_read_version(PchReader* r) {
+    int len = pch_read_int(r);
+    if (len != (int)strlen(DUCC_VERSION) || r->len - r->pos < (size_t)len) {
+        return false;
+    }
+    bool same = memcmp(r->buf + r->pos, DUCC_VERSION, len) == 0;
+    r->pos += len;
+    return same;
+}
+
+static void pch_read_tokens(PchReader* r, TokenArray* tokens) {
+    int n = pch_read_int(r);
+    tokens_init(tokens, n > 0 ? n : 1);
+    for (int i = 0; i < n; ++i) {
+        Token* tok = tokens_push_new(tokens);
+        pch_read_bytes(r, tok, sizeof(Token));
+        if (token_has_string_value(tok->kind)) {
+            int index = tok->value.integer;
+            if (index < 0 || r->string_count <= index) {
+                fatal_error("%s: invalid precompiled header", r->filename);
+            }
+            tok->value.string = r->strings[index];
+        }
+    }
+}
 
-    preprocess_preprocessing_file(pp);
-    remove_pp_directives(pp);
-    return pp->pp_tokens;
+// The options that affect preprocessing must be the same as when the header was precompiled.
+static void pch_check_options(PchReader* r, StrArray* options, const char* option_name) {
+    int n = pch_read_int(r);
+    bool same = (size_t)n == options->len;
+    for (int i = 0; i < n; ++i) {
+        const char* option = pch_read_string(r);
+        if (same && strcmp(option, options->data[i]) != 0) {
+            same = false;
+        }
+    }
+    if (!same) {
+        fatal_error("%s: precompiled header was built with different %s options", r->filename, option_name);
+    }
+}
+
+PrecompiledHeader* pch_load(const char* filename, StrArray* user_defines, StrArray* user_include_dirs) {
+    PchReader r;
+    r.filename = filename;
+    r.buf = file_map_contents(filename, &r.len);
+    r.pos = 0;
+    if (!r.buf) {
+        fatal_error("cannot open precompiled header: %s", filename);
+    }
+    if (r.len < strlen(PCH_MAGIC) || memcmp(r.buf, PCH_MAGIC, strlen(PCH_MAGIC)) != 0) {
+        fatal_error("%s: not a precompiled header", filename);
+    }
+    r.pos = strlen(PCH_MAGIC);
+    if (!pch_read_version(&r) || pch_read_int(&r) != PCH_VERSION || pch_read_int(&r) != (int)sizeof(Token)) {
+        fatal_error("%s: precompiled header was built by another version of ducc", filename);
+    }
+
+    r.string_count = pch_read_int(&r);
+    if (r.string_count < 0) {
+        fatal_error("%s: invalid precompiled header", filename);
+    }
+    r.strings = calloc(r.string_count + 1, sizeof(const char*));
+    for (int i = 0; i < r.string_count; ++i) {
+        int len = pch_read_int(&r);
+        if (len < 0 || r.len - r.pos <= (size_t)len) {
+            fatal_error("%s: invalid precompiled header", filename);
+        }
+        r.strings[i] = atom_intern(r.buf + r.pos, len);
+        r.pos += len + 1;
+    }
+
+    pch_check_options(&r, user_defines, "-D");
+    pch_check_options(&r, user_include_dirs, "-I");
+
+    // Opening the source files again in the same order gives their positions back to the tokens.
+    int n_files = pch_read_int(&r);
+    for (int i = 0; i < n_files; ++i) {
+        const char* source_filename = pch_read_string(&r);
+        SourcePos base = pch_read_int(&r);
+        long len = pch_read_long(&r);
+        long mtime_sec = pch_read_long(&r);
+        long mtime_nsec = pch_read_long(&r);
+        InFile* f = infile_open(source_filename);
+        if (!f || f->text->len != (size_t)len || f->text->mtime_sec != mtime_sec ||
+            f->text->mtime_nsec != mtime_nsec) {
+            fatal_error("%s: precompiled header is out of date, %s has changed", filename, source_filename);
+        }
+        if (f->base != base) {
+            fatal_error("%s: precompiled header must be loaded before any source file", filename);
+        }
+    }
+
+    PrecompiledHeader* pch = calloc(1, sizeof(PrecompiledHeader));
+
+    int n_included_files = pch_read_int(&r);
+    strings_init(&pch->included_files);
+    for (int i = 0; i < n_included_files; ++i) {
+        strings_push(&pch->included_files, pch_read_string(&r));
+    }
+
+    pch->file_guards = file_guards_new();
+    int n_guards = pch_read_int(&r);
+    for (int i = 0; i < n_guards; ++i) {
+        FileGuard* guard = file_guards_get(pch->file_guards, pch_read_string(&r));
+        guard->guard_macro = pch_read_string(&r);
+        guard->pragma_once = pch_read_int(&r);
+    }
+
+    pch->macros = macros_new();
+    int n_macros = pch_read_int(&r);
+    for (int i = 0; i < n_macros; ++i) {
+        Macro* m = macros_define(pch->macros, pch_read_string(&r));
+        m->kind = pch_read_int(&r);
+        pch_read_tokens(&r, &m->parameters);
+        pch_read_tokens(&r, &m->replacements);
+    }
+
+    pch_read_tokens(&r, &pch->tokens);
+    if (pch->tokens.len == 0 || pch->tokens.data[pch->tokens.len - 1].kind != TokenKind_eof) {
+        fatal_error("%s: invalid precompiled header", filename);
+    }
+    return pch;
 }
 
 TokenArray* preprocess(InFile* src, StrArray* user_defines, StrArray* user_include_dirs, StrArray* included_files,
-                       bool generate_system_deps, bool generate_user_deps) {
-    MacroArray* macros = macros_new();
-    add_predefined_macros(macros);
-    add_user_defines(macros, user_defines);
-    strings_push(included_files, src->loc.filename);
+                       bool generate_system_deps, bool generate_user_deps, bool deps_only, PrecompiledHeader* pch,
+                       const char* pch_output_filename) {
+    record_included_file(included_files, src->filename);
+
+    TokenArray* pp_tokens = calloc(1, sizeof(TokenArray));
+    MacroArray* macros;
+    FileGuardArray* file_guards;
+    if (pch) {
+        // The header's tokens come first, as if it were included at the top of `src`.
+        macros = pch->macros;
+        file_guards = pch->file_guards;
+        for (size_t i = 0; i < pch->included_files.len; ++i) {
+            record_included_file(included_files, pch->included_files.data[i]);
+        }
+        tokens_init(pp_tokens, pch->tokens.len + 64);
+        memcpy(pp_tokens->data, pch->tokens.data, pch->tokens.len * sizeof(Token));
+        pp_tokens->len = pch->tokens.len;
+        // The EOF token still holds the new-lines at the end of the header.
+        pp_tokens->data[pp_tokens->len - 1].kind = TokenKind_removed;
+    } else {
+        macros = macros_new();
+        add_predefined_macros(macros);
+        add_user_defines(macros, user_defines);
+        file_guards = file_guards_new();
+        tokens_init(pp_tokens, 64);
+    }
 
     StrArray* include_paths = calloc(1, sizeof(StrArray));
     strings_init(include_paths);
 
     // Ducc's built-in headers has highest priority.
-    strings_push(include_paths, get_ducc_include_path());
+    strings_push(include_paths, BUILTIN_INCLUDE_DIR);
 
     for (size_t i = 0; i < user_include_dirs->len; ++i) {
         strings_push(include_paths, user_include_dirs->data[i]);
@@ -1496,7 +2815,14 @@ TokenArray* preprocess(InFile* src, StrArray* user_defines, StrArray* user_inclu
     strings_push(include_paths, "/usr/include/x86_64-linux-gnu");
     strings_push(include_paths, "/usr/include");
 
-    return do_preprocess(src, 0, macros, include_paths, included_files, generate_system_deps, generate_user_deps);
+    do_preprocess(pp_tokens, src, 0, macros, include_paths, included_files, file_guards, generate_system_deps,
+                  generate_user_deps, deps_only);
+
+    if (pch_output_filename) {
+        write_pch(pch_output_filename, pp_tokens, macros, file_guards, included_files, user_defines,
+                  user_include_dirs);
+    }
+    return pp_tokens;
 }
 
 void concat_adjacent_string_literals(TokenArray* pp_tokens) {
@@ -1505,7 +2831,7 @@ void concat_adjacent_string_literals(TokenArray* pp_tokens) {
     for (size_t pos = 0; pos < pp_tokens->len; ++pos) {
         Token* pp_tok = &pp_tokens->data[pos];
         TokenKind k = pp_tok->kind;
-        if (k == TokenKind_removed || k == TokenKind_whitespace || k == TokenKind_newline) {
+        if (k == TokenKind_removed) {
             continue;
         }
         if (k == TokenKind_literal_str && last_nonempty_token_kind == TokenKind_literal_str) {
@@ -1527,33 +2853,187 @@ void concat_adjacent_string_literals(TokenArray* pp_tokens) {
     }
 }
 
-void print_token_to_file(FILE* out, TokenArray* pp_tokens) {
+// Output of -E, collected in a large buffer and written out when it is full, so that each token costs a copy of its
+// text rather than a call into stdio.
+typedef struct {
+    FILE* out;
+    char* buf;
+    size_t len;
+    size_t capacity;
+} PpWriter;
+
+static void pp_writer_flush(PpWriter* w) {
+    if (w->len > 0 && fwrite(w->buf, 1, w->len, w->out) != w->len) {
+        fatal_error("cannot write preprocessed output");
+    }
+    w->len = 0;
+}
+
+static void pp_writer_write(PpWriter* w, const char* s, size_t len) {
+    if (w->capacity - w->len < len) {
+        pp_writer_flush(w);
+        if (w->capacity < len) {
+            if (fwrite(s, 1, len, w->out) != len) {
+                fatal_error("cannot write preprocessed output");
+            }
+            return;
+        }
+    }
+    memcpy(w->buf + w->len, s, len);
+    w->len += len;
+}
+
+static void pp_writer_write_char(PpWriter* w, char c) {
+    if (w->len == w->capacity) {
+        pp_writer_flush(w);
+    }
+    w->buf[w->len++] = c;
+}
+
+static void pp_writer_write_string(PpWriter* w, const char* s) {
+    pp_writer_write(w, s, strlen(s));
+}
+
+static void pp_writer_write_int(PpWriter* w, int n) {
+    // Computed in long so that INT_MIN can be negated.
+    long v = n;
+    if (v < 0) {
+        pp_writer_write_char(w, '-');
+        v = -v;
+    }
+    char digits[16];
+    int i = sizeof(digits);
+    do {
+        digits[--i] = '0' + v % 10;
+        v /= 10;
+    } while (v != 0);
+    pp_writer_write(w, digits + i, sizeof(digits) - i);
+}
+
+// Writes the spelling of a token, as token_stringify(), but without allocating.
+static void pp_writer_write_token(PpWriter* w, Token* tok) {
+    TokenKind k = tok->kind;
+    if (k == TokenKind_pp_directive_non_directive) {
+        pp_writer_write_char(w, '#');
+        pp_writer_write_string(w, tok->value.string);
+    } else if (k == TokenKind_literal_int) {
+        pp_writer_write_int(w, tok->value.integer);
+    } else if (k == TokenKind_literal_double) {
+        char buf[32];
+        int len = snprintf(buf, sizeof(buf), "%g", tok->value.floating);
+        pp_writer_write(w, buf, len);
+    } else if (k == TokenKind_embedded_data) {
+        const EmbeddedData* embedded = tok->value.embedded_data;
+        for (size_t i = 0; i < embedded->len; ++i) {
+            if (i > 0) {
+                pp_writer_write_char(w, ',');
+            }
+            pp_writer_write_int(w, embedded->data[i] & 0xff);
+        }
+    } else if (k == TokenKind_other || k == TokenKind_character_constant || k == TokenKind_ident ||
+               k == TokenKind_literal_str || k == TokenKind_header_name) {
+        pp_writer_write_string(w, tok->value.string);
+    } else {
+        pp_writer_write_string(w, token_kind_stringify(k));
+    }
+}
+
+// # <line> "<file>", as GCC writes it.
+static void pp_writer_write_line_marker(PpWriter* w, int line, const char* filename) {
+    pp_writer_write_string(w, "# ");
+    pp_writer_write_int(w, line);
+    pp_writer_write_string(w, " \"");
+    for (const char* p = filename; *p; ++p) {
+        if (*p == '\\' || *p == '"') {
+            pp_writer_write_char(w, '\\');
+        }
+        pp_writer_write_char(w, *p);
+    }
+    pp_writer_write_string(w, "\"\n");
+}
+
+// Up to this many blank lines are written to keep the output lines in step with the source; a longer gap gets a line
+// marker instead, as in GCC.
+#define PP_MAX_BLANK_LINES 8
+
+void print_token_to_file(FILE* out, TokenArray* pp_tokens, bool line_markers) {
+    PpWriter w;
+    w.out = out;
+    w.capacity = 64 * 1024;
+    w.buf = malloc(w.capacity);
+    w.len = 0;
+
+    // With line markers, the file and line that the output is at.
+    const char* current_filename = NULL;
+    int current_line = 0;
+    SourcePos last_pos = 0;
+    SourceLocation loc;
+
     for (size_t i = 0; i < pp_tokens->len; ++i) {
         Token* tok = &pp_tokens->data[i];
 
-        if (tok->kind == TokenKind_whitespace) {
-            // TODO: preserve indent?
-            fprintf(out, " ");
-        } else if (tok->kind == TokenKind_removed) {
-            // Output nothing for removed tokens
-        } else if (tok->kind == TokenKind_newline) {
+        if (!line_markers) {
             // TODO: remove adjacent newlines?
-            fprintf(out, "\n");
-        } else if (tok->kind != TokenKind_eof) {
-            // TODO: string literal
-            fprintf(out, "%s", token_stringify(tok));
-            // Add space after token if next token is not punctuation
-            // TODO: apply stricter approach
-            if (i + 1 < pp_tokens->len) {
-                Token* next = &pp_tokens->data[i + 1];
-                if (next->kind != TokenKind_newline && next->kind != TokenKind_whitespace &&
-                    next->kind != TokenKind_removed && next->kind != TokenKind_eof && next->kind != TokenKind_comma &&
-                    next->kind != TokenKind_semicolon && next->kind != TokenKind_paren_r &&
-                    next->kind != TokenKind_bracket_r && next->kind != TokenKind_brace_r &&
-                    next->kind != TokenKind_dot) {
-                    fprintf(out, " ");
+            for (int j = 0; j < tok->newlines; ++j) {
+                pp_writer_write_char(&w, '\n');
+            }
+        }
+        if (tok->kind == TokenKind_removed || tok->kind == TokenKind_eof) {
+            // Output nothing for removed tokens
+            continue;
+        }
+
+        // Tokens without a position, such as the value of __LINE__, are written on the current line.
+        if (line_markers && tok->pos != 0) {
+            // Tokens from the same macro invocation share a position, which is only decoded once.
+            if (tok->pos != last_pos) {
+                loc = source_pos_decode(tok->pos);
+                last_pos = tok->pos;
+            }
+            const char* filename = loc.filename;
+            int line = loc.line;
+            bool same_file =
+                current_filename && (filename == current_filename || strcmp(filename, current_filename) == 0);
+            if (!same_file || line < current_line || current_line + PP_MAX_BLANK_LINES < line) {
+                if (current_filename) {
+                    pp_writer_write_char(&w, '\n');
+                }
+                pp_writer_write_line_marker(&w, line, filename);
+                current_filename = filename;
+                current_line = line;
+            } else if (current_line < line) {
+                for (; current_line < line; ++current_line) {
+                    pp_writer_write_char(&w, '\n');
                 }
+            } else if (tok->newlines > 0 && !(tok->flags & TokenFlag_leading_space)) {
+                // A token that started a line in the source, but is put on the line of the macro invocation it was
+                // passed to.
+                pp_writer_write_char(&w, ' ');
             }
         }
+
+        if (tok->flags & TokenFlag_leading_space) {
+            // TODO: preserve indent?
+            pp_writer_write_char(&w, ' ');
+        }
+        // TODO: string literal
+        pp_writer_write_token(&w, tok);
+        // Add space after token if next token is not punctuation
+        // TODO: apply stricter approach
+        if (i + 1 < pp_tokens->len) {
+            Token* next = &pp_tokens->data[i + 1];
+            if (next->newlines == 0 && !(next->flags & TokenFlag_leading_space) && next->kind != TokenKind_removed &&
+                next->kind != TokenKind_eof && next->kind != TokenKind_comma && next->kind != TokenKind_semicolon &&
+                next->kind != TokenKind_paren_r && next->kind != TokenKind_bracket_r &&
+                next->kind != TokenKind_brace_r && next->kind != TokenKind_dot) {
+                pp_writer_write_char(&w, ' ');
+            }
+        }
+    }
+    if (line_markers && current_filename) {
+        pp_writer_write_char(&w, '\n');
     }
+
+    pp_writer_flush(&w);
+    free(w.buf);
 }
@@ -5,9 +5,34 @@
 #include "io.h"
 #include "token.h"
 
+typedef struct {
+    // Lookups in the macro table's hash index, and the slots they looked at in total.
+    long lookups;
+    long probes;
+    int max_probes;
+    // Distinct macro names ever defined, and the number of slots in the index.
+    int names;
+    int index_capacity;
+    // Expansions of object-like macros taken from their cache, and expansions stored in it.
+    long expansion_cache_hits;
+    long expansion_cache_stores;
+} MacroTableStats;
+
+typedef struct PrecompiledHeader PrecompiledHeader;
+
+// Reads a precompiled header and checks it against the source files it was made from and the -D and -I options. It must
+// be loaded before any source file is opened, so that the source files it refers to get back their positions.
+PrecompiledHeader* pch_load(const char* filename, StrArray* user_defines, StrArray* user_include_dirs);
+
+// If `pch` is given, its state is restored first, as if its header were included at the top of `src`. If
+// `pch_output_filename` is given, the state after preprocessing `src` is written there as a precompiled header. With
+// `deps_only`, only `included_files` is of use: the text lines are dropped from the result.
 TokenArray* preprocess(InFile* src, StrArray* user_defines, StrArray* user_include_dirs, StrArray* included_files,
-                       bool generate_system_deps, bool generate_user_deps);
+                       bool generate_system_deps, bool generate_user_deps, bool deps_only, PrecompiledHeader* pch,
+                       const char* pch_output_filename);
 void concat_adjacent_string_literals(TokenArray* pp_tokens);
-void print_token_to_file(FILE* output_file, TokenArray* pp_tokens);
+// Writes the output of -E. With `line_markers`, lines are kept in step with the source by # <line> "<file>" lines.
+void print_token_to_file(FILE* output_file, TokenArray* pp_tokens, bool line_markers);
+const MacroTableStats* macro_table_stats();
 
 #endif
@@ -0,0 +1,185 @@
+#include "scan.h"
+#include <stdint.h>
+#include <string.h>
+
+static ScanKernel scan_kernel = ScanKernel_swar;
+
+void scan_set_kernel(ScanKernel kernel) {
+    scan_kernel = kernel;
+}
+
+static bool is_digit(char c) {
+    return '0' <= c && c <= '9';
+}
+
+static bool is_alpha(char c) {
+    return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+}
+
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// SWAR helpers. A "mask" has the high bit of each byte set for the bytes that match and all other bits clear.
+
+// 0x0101010101010101, built at runtime because ducc does not support 64-bit integer literals.
+static uint64_t swar_ones() {
+    uint64_t ones = 0x01010101;
+    return ones | (ones << 32);
+}
+
+static uint64_t swar_load(const char* p) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+static uint64_t swar_eq(uint64_t w, uint64_t ones, char c) {
+    uint64_t low7 = ones * 0x7f;
+    uint64_t x = w ^ (ones * c);
+    // The high bit of each byte is set iff the byte of x is non-zero. Adding 0x7f to the low seven bits never carries
+    // into the next byte.
+    uint64_t non_zero = ((x & low7) + low7) | x;
+    return ~non_zero & (ones * 0x80);
+}
+
+// `w7` must have the high bit of every byte clear, and `hi` must be below 0x80.
+static uint64_t swar_in_range(uint64_t w7, uint64_t ones, char lo, char hi) {
+    uint64_t high = ones * 0x80;
+    // Each byte of (w7 | high) is at least 0x80, so subtracting a value up to 0x80 never borrows from the next byte,
+    // and the high bit survives iff the byte was at least that value.
+    uint64_t ge_lo = ((w7 | high) - ones * lo) & high;
+    uint64_t ge_hi = ((w7 | high) - ones * (hi + 1)) & high;
+    return ge_lo & ~ge_hi;
+}
+
+static uint64_t swar_alnum(uint64_t w, uint64_t ones) {
+    uint64_t w7 = w & (ones * 0x7f);
+    uint64_t m =
+        swar_in_range(w7, ones, '0', '9') | swar_in_range(w7, ones, 'A', 'Z') | swar_in_range(w7, ones, 'a', 'z');
+    // Bytes at or above 0x80 never match.
+    return m & ~w;
+}
+
+// Returns the index of the lowest-addressed byte marked in a non-zero mask.
+static int swar_first(uint64_t mask) {
+    int i = 0;
+    while (!(mask & 0x80)) {
+        mask >>= 8;
+        ++i;
+    }
+    return i;
+}
+
+const char* scan_ident(const char* p, const char* end) {
+    if (scan_kernel == ScanKernel_swar) {
+        uint64_t ones = swar_ones();
+        uint64_t high = ones * 0x80;
+        while (p + 8 <= end) {
+            uint64_t w = swar_load(p);
+            uint64_t stop = ~(swar_alnum(w, ones) | swar_eq(w, ones, '_')) & high;
+            if (stop) {
+                return p + swar_first(stop);
+            }
+            p += 8;
+        }
+    }
+    while (p < end && (is_alpha(*p) || is_digit(*p) || *p == '_')) {
+        ++p;
+    }
+    return p;
+}
+
+const char* scan_alnum(const char* p, const char* end) {
+    if (scan_kernel == ScanKernel_swar) {
+        uint64_t ones = swar_ones();
+        uint64_t high = ones * 0x80;
+        while (p + 8 <= end) {
+            uint64_t w = swar_load(p);
+            uint64_t stop = ~swar_alnum(w, ones) & high;
+            if (stop) {
+                return p + swar_first(stop);
+            }
+            p += 8;
+        }
+    }
+    while (p < end && (is_alpha(*p) || is_digit(*p))) {
+        ++p;
+    }
+    return p;
+}
+
+const char* scan_blank(const char* p, const char* end) {
+    if (scan_kernel == ScanKernel_swar) {
+        uint64_t ones = swar_ones();
+        uint64_t high = ones * 0x80;
+        while (p + 8 <= end) {
+            uint64_t w = swar_load(p);
+            uint64_t m =
+                swar_eq(w, ones, ' ') | swar_eq(w, ones, '\t') | swar_eq(w, ones, '\v') | swar_eq(w, ones, '\f');
+            uint64_t stop = ~m & high;
+            if (stop) {
+                return p + swar_first(stop);
+            }
+            p += 8;
+        }
+    }
+    while (p < end && is_blank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+const char* scan_until(const char* p, const char* end, char c) {
+    if (scan_kernel == ScanKernel_swar) {
+        uint64_t ones = swar_ones();
+        while (p + 8 <= end) {
+            uint64_t stop = swar_eq(swar_load(p), ones, c);
+            if (stop) {
+                return p + swar_first(stop);
+            }
+            p += 8;
+        }
+    }
+    while (p < end && *p != c) {
+        ++p;
+    }
+    return p;
+}
+
+const char* scan_string_body(const char* p, const char* end) {
+    if (scan_kernel == ScanKernel_swar) {
+        uint64_t ones = swar_ones();
+        while (p + 8 <= end) {
+            uint64_t w = swar_load(p);
+            uint64_t stop = swar_eq(w, ones, '"') | swar_eq(w, ones, '\\');
+            if (stop) {
+                return p + swar_first(stop);
+            }
+            p += 8;
+        }
+    }
+    while (p < end && *p != '"' && *p != '\\') {
+        ++p;
+    }
+    return p;
+}
+
+const char* scan_skipped_text(const char* p, const char* end) {
+    if (scan_kernel == ScanKernel_swar) {
+        uint64_t ones = swar_ones();
+        while (p + 8 <= end) {
+            uint64_t w = swar_load(p);
+            uint64_t stop =
+                swar_eq(w, ones, '\n') | swar_eq(w, ones, '"') | swar_eq(w, ones, '\'') | swar_eq(w, ones, '/');
+            if (stop) {
+                return p + swar_first(stop);
+            }
+            p += 8;
+        }
+    }
+    while (p < end && *p != '\n' && *p != '"' && *p != '\'' && *p != '/') {
+        ++p;
+    }
+    return p;
+}
@@ -0,0 +1,32 @@
+#ifndef DUCC_SCAN_H
+#define DUCC_SCAN_H
+
+#include "../lib/ducc.h"
+
+// Kernels used by the lexer to skip over a run of bytes of one class at once. Each returns the first byte in [p, end)
+// that does not belong to the run, or `end`. They look at raw bytes only, so the caller must keep line splices and CRs
+// out of the range (see infile_raw_end()).
+typedef enum {
+    // Eight bytes per step, tested in parallel within a 64-bit word.
+    ScanKernel_swar,
+    // One byte per step. Kept for comparison and as a reference for the SWAR kernels.
+    ScanKernel_scalar,
+} ScanKernel;
+
+void scan_set_kernel(ScanKernel kernel);
+
+// [A-Za-z0-9_]
+const char* scan_ident(const char* p, const char* end);
+// [A-Za-z0-9]
+const char* scan_alnum(const char* p, const char* end);
+// ' ', '\t', '\v' and '\f'
+const char* scan_blank(const char* p, const char* end);
+// Any byte except `c`.
+const char* scan_until(const char* p, const char* end, char c);
+// Any byte except '"' and '\\'.
+const char* scan_string_body(const char* p, const char* end);
+// Any byte except '\n', '"', '\'' and '/', i.e. the text of a skipped line up to where a comment or a literal may
+// start.
+const char* scan_skipped_text(const char* p, const char* end);
+
+#endif
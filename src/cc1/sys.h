@@ -1,7 +0,0 @@
-#ifndef DUCC_SYS_H
-#define DUCC_SYS_H
-
-// It returns a path not including final / except for root directory.
-char* get_self_dir();
-
-#endif
@@ -11,12 +11,12 @@ const char* token_kind_stringify(TokenKind k) {
         return "##";
     else if (k == TokenKind_whitespace)
         return "<whitespace>";
+    else if (k == TokenKind_newline)
+        return "<new-line>";
     else if (k == TokenKind_removed)
         return "<removed>";
     else if (k == TokenKind_placemarker)
         return "<placemarker>";
-    else if (k == TokenKind_newline)
-        return "<new-line>";
     else if (k == TokenKind_other)
         return "<other>";
     else if (k == TokenKind_character_constant)
@@ -221,6 +221,8 @@ const char* token_kind_stringify(TokenKind k) {
         return ".";
     else if (k == TokenKind_ellipsis)
         return "...";
+    else if (k == TokenKind_embedded_data)
+        return "<embedded-data>";
     else if (k == TokenKind_eq)
         return "==";
     else if (k == TokenKind_ge)
@@ -300,7 +302,8 @@ const char* token_stringify(Token* tok) {
         sprintf(buf, "#%s", tok->value.string);
         return buf;
     } else if (k == TokenKind_literal_int) {
-        char* buf = calloc(10, sizeof(char));
+        // Room for INT_MIN.
+        char* buf = calloc(12, sizeof(char));
         sprintf(buf, "%d", tok->value.integer);
         return buf;
     } else if (k == TokenKind_literal_double) {
@@ -310,6 +313,17 @@ const char* token_stringify(Token* tok) {
     } else if (k == TokenKind_other || k == TokenKind_character_constant || k == TokenKind_ident ||
                k == TokenKind_literal_str || k == TokenKind_header_name) {
         return tok->value.string;
+    } else if (k == TokenKind_embedded_data) {
+        // The bytes as a comma-separated list, as if they had been spelled out.
+        const EmbeddedData* embedded = tok->value.embedded_data;
+        StrBuilder builder;
+        strbuilder_init(&builder);
+        for (size_t i = 0; i < embedded->len; ++i) {
+            char buf[8];
+            sprintf(buf, i == 0 ? "%d" : ",%d", embedded->data[i] & 0xff);
+            strbuilder_append_string(&builder, buf);
+        }
+        return builder.buf;
     } else {
         return token_kind_stringify(k);
     }
@@ -334,12 +348,24 @@ void token_build_json(JsonBuilder* builder, Token* tok) {
         jsonbuilder_null(builder);
     }
     jsonbuilder_object_member_end(builder);
+    jsonbuilder_object_member_start(builder, "flags");
+    jsonbuilder_integer(builder, tok->flags);
+    jsonbuilder_object_member_end(builder);
     jsonbuilder_object_member_start(builder, "loc");
-    sourcelocation_build_json(builder, &tok->loc);
+    SourceLocation loc = source_pos_decode(tok->pos);
+    sourcelocation_build_json(builder, &loc);
     jsonbuilder_object_member_end(builder);
     jsonbuilder_object_end(builder);
 }
 
+const char* token_filename(const Token* tok) {
+    return source_pos_decode(tok->pos).filename;
+}
+
+int token_line(const Token* tok) {
+    return source_pos_decode(tok->pos).line;
+}
+
 void tokens_init(TokenArray* tokens, size_t capacity) {
     tokens->len = 0;
     tokens->capacity = capacity;
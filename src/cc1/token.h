@@ -10,10 +10,11 @@ typedef enum {
     // Only preprocessing phase.
     TokenKind_hash,
     TokenKind_hashhash,
+    // Only inside the lexer. Whitespace and new-lines are recorded as flags of the following token; see TokenFlag.
     TokenKind_whitespace,
+    TokenKind_newline,
     TokenKind_removed,
     TokenKind_placemarker,
-    TokenKind_newline,
     TokenKind_other,
     TokenKind_character_constant,
     TokenKind_header_name,
@@ -119,6 +120,8 @@ typedef enum {
     TokenKind_comma,
     TokenKind_dot,
     TokenKind_ellipsis,
+    // The contents of a resource named by #embed, in one token instead of a comma-separated list of integers.
+    TokenKind_embedded_data,
     TokenKind_eq,
     TokenKind_ge,
     TokenKind_gt,
@@ -152,20 +155,45 @@ typedef enum {
 const char* token_kind_stringify(TokenKind k);
 bool is_pp_directive(TokenKind k);
 
+typedef struct {
+    // Not NUL-terminated. It may point into a memory-mapped file, so it is never freed or written to.
+    const char* data;
+    size_t len;
+} EmbeddedData;
+
 // TokenValue is externally tagged by Token's kind.
 typedef union {
     const char* string;
     int integer;
     double floating;
+    const EmbeddedData* embedded_data;
 } TokenValue;
 
+typedef enum {
+    // Whitespace or a comment comes between this token and the previous one on the same line.
+    TokenFlag_leading_space = 1 << 0,
+    // This is the first token of a line.
+    TokenFlag_at_bol = 1 << 1,
+    // An identifier that names a macro whose expansion it came up in. It is never expanded, not even when it is
+    // examined again later (C23 6.10.5.4), i.e. it is "painted blue".
+    TokenFlag_no_expand = 1 << 2,
+} TokenFlag;
+
+// 16 bytes: the location is kept as a SourcePos and decoded only when a diagnostic or the AST needs it.
 typedef struct {
-    TokenKind kind;
     TokenValue value;
-    SourceLocation loc;
+    SourcePos pos;
+    // TokenKind, in two bytes to leave room for the rest.
+    unsigned short kind;
+    // TokenFlag bits.
+    char flags;
+    // Number of new-lines right before this token that are still to be written by -E, up to CHAR_MAX.
+    char newlines;
 } Token;
 
 const char* token_stringify(Token* tok);
+const char* token_filename(const Token* tok);
+int token_line(const Token* tok);
 void token_build_json(JsonBuilder* builder, Token* tok);
 
 typedef struct {
@@ -1,26 +1,105 @@
 #include "tokenize.h"
 #include <ctype.h>
+#include <limits.h>
+#include "../lib/arena.h"
 #include "../lib/common.h"
+#include "atom.h"
+#include "scan.h"
 
-typedef struct {
-    InFile* src;
-    bool at_bol;
-    bool expect_header_name;
-    TokenArray* tokens;
-} Lexer;
-
-static Lexer* lexer_new(InFile* src) {
+Lexer* lexer_new(InFile* src, TokenArray* tokens) {
     Lexer* l = calloc(1, sizeof(Lexer));
 
     l->src = src;
     l->at_bol = true;
     l->expect_header_name = false;
-    l->tokens = calloc(1, sizeof(TokenArray));
-    tokens_init(l->tokens, 1024 * 16);
+    l->next_flags = TokenFlag_at_bol;
+    l->next_newlines = 0;
+    l->tokens = tokens;
+    l->reached_eof = false;
 
     return l;
 }
 
+// Appends the bytes from the current position up to `end` to `builder` and moves past them. `end` is found by one of
+// the scan_*() kernels, which stop at the next line splice or CR at the latest; the caller decides whether to continue
+// after infile_peek_char() has dealt with it.
+static void append_raw(InFile* src, StrBuilder* builder, const char* end) {
+    const char* start = infile_raw(src);
+    strbuilder_append_bytes(builder, start, end - start);
+    infile_advance_raw(src, end - start);
+}
+
+static void skip_raw(InFile* src, const char* end) {
+    infile_advance_raw(src, end - infile_raw(src));
+}
+
+// Skips the body of a "//" comment, leaving the new-line.
+static void skip_line_comment(InFile* src) {
+    while (1) {
+        skip_raw(src, scan_until(infile_raw(src), infile_raw_end(src), '\n'));
+        if (infile_eof(src) || infile_peek_char(src) == '\n') {
+            break;
+        }
+        infile_next_char(src);
+    }
+}
+
+// Skips the body of a "/*" comment and the closing "*/".
+static void skip_block_comment(InFile* src) {
+    while (1) {
+        skip_raw(src, scan_until(infile_raw(src), infile_raw_end(src), '*'));
+        char ch = infile_peek_char(src);
+        if (ch == '\0') {
+            break;
+        }
+        infile_next_char(src);
+        if (ch == '*' && infile_consume_if(src, '/')) {
+            break;
+        }
+    }
+}
+
+// Skips the rest of a string literal or character constant whose opening `quote` has been read. In a skipped group an
+// unterminated one is not an error, so it also ends at the end of the line.
+static void skip_quoted(InFile* src, char quote) {
+    while (!infile_eof(src)) {
+        char c = infile_peek_char(src);
+        if (c == '\n') {
+            break;
+        }
+        infile_next_char(src);
+        if (c == quote) {
+            break;
+        }
+        if (c == '\\' && infile_peek_char(src) != '\n') {
+            infile_next_char(src);
+        }
+    }
+}
+
+static bool is_ident_char(char c) {
+    return isalnum(c) || c == '_';
+}
+
+// Reads a run of identifier characters, which may be empty, and returns it as an atom. Unless the run is broken by a
+// line splice, it is interned straight from the buffer without being copied.
+static const char* read_identifier(InFile* src) {
+    const char* start = infile_raw(src);
+    const char* end = scan_ident(start, infile_raw_end(src));
+    infile_advance_raw(src, end - start);
+    if (!is_ident_char(infile_peek_char(src))) {
+        return atom_intern(start, end - start);
+    }
+
+    StrBuilder builder;
+    strbuilder_init(&builder);
+    strbuilder_append_bytes(&builder, start, end - start);
+    do {
+        append_raw(src, &builder, scan_ident(infile_raw(src), infile_raw_end(src)));
+    } while (is_ident_char(infile_peek_char(src)));
+    return atom_intern(builder.buf, builder.len);
+}
+
 static void pplexer_tokenize_pp_directive(Lexer* l, Token* tok) {
     // Skip whitespaces after '#'.
     char c;
@@ -35,62 +114,28 @@ static void pplexer_tokenize_pp_directive(Lexer* l, Token* tok) {
         return;
     }
 
-    StrBuilder builder;
-    strbuilder_init(&builder);
-    while (isalnum(infile_peek_char(l->src)) || infile_peek_char(l->src) == '_') {
-        strbuilder_append_char(&builder, infile_peek_char(l->src));
-        infile_next_char(l->src);
+    const char* pp_directive_name = read_identifier(l->src);
+    if (pp_directive_name[0] == '\0') {
+        tok->kind = TokenKind_hash;
+        return;
     }
-    const char* pp_directive_name = builder.buf;
 
-    if (builder.len == 0) {
-        tok->kind = TokenKind_hash;
-    } else if (strcmp(pp_directive_name, "define") == 0) {
-        tok->kind = TokenKind_pp_directive_define;
-    } else if (strcmp(pp_directive_name, "elif") == 0) {
-        tok->kind = TokenKind_pp_directive_elif;
-    } else if (strcmp(pp_directive_name, "elifdef") == 0) {
-        tok->kind = TokenKind_pp_directive_elifdef;
-    } else if (strcmp(pp_directive_name, "elifndef") == 0) {
-        tok->kind = TokenKind_pp_directive_elifndef;
-    } else if (strcmp(pp_directive_name, "else") == 0) {
-        tok->kind = TokenKind_pp_directive_else;
-    } else if (strcmp(pp_directive_name, "embed") == 0) {
-        tok->kind = TokenKind_pp_directive_embed;
-    } else if (strcmp(pp_directive_name, "endif") == 0) {
-        tok->kind = TokenKind_pp_directive_endif;
-    } else if (strcmp(pp_directive_name, "error") == 0) {
-        tok->kind = TokenKind_pp_directive_error;
-    } else if (strcmp(pp_directive_name, "if") == 0) {
-        tok->kind = TokenKind_pp_directive_if;
-    } else if (strcmp(pp_directive_name, "ifdef") == 0) {
-        tok->kind = TokenKind_pp_directive_ifdef;
-    } else if (strcmp(pp_directive_name, "ifndef") == 0) {
-        tok->kind = TokenKind_pp_directive_ifndef;
-    } else if (strcmp(pp_directive_name, "include") == 0) {
+    tok->kind = atom_directive_kind(pp_directive_name);
+    if (tok->kind == TokenKind_pp_directive_include || tok->kind == TokenKind_pp_directive_include_next ||
+        tok->kind == TokenKind_pp_directive_embed) {
         l->expect_header_name = true;
-        tok->kind = TokenKind_pp_directive_include;
-    } else if (strcmp(pp_directive_name, "include_next") == 0) {
-        l->expect_header_name = true;
-        tok->kind = TokenKind_pp_directive_include_next;
-    } else if (strcmp(pp_directive_name, "line") == 0) {
-        tok->kind = TokenKind_pp_directive_line;
-    } else if (strcmp(pp_directive_name, "pragma") == 0) {
-        tok->kind = TokenKind_pp_directive_pragma;
-    } else if (strcmp(pp_directive_name, "undef") == 0) {
-        tok->kind = TokenKind_pp_directive_undef;
-    } else if (strcmp(pp_directive_name, "warning") == 0) {
-        tok->kind = TokenKind_pp_directive_warning;
-    } else {
-        tok->kind = TokenKind_pp_directive_non_directive;
+    } else if (tok->kind == TokenKind_pp_directive_non_directive) {
         tok->value.string = pp_directive_name;
     }
 }
 
-static void do_tokenize_all(Lexer* l) {
+void lexer_next(Lexer* l) {
+    if (l->reached_eof) {
+        return;
+    }
     while (!infile_eof(l->src)) {
         Token* tok = tokens_push_new(l->tokens);
-        tok->loc = l->src->loc;
+        tok->pos = infile_source_pos(l->src);
         char c = infile_peek_char(l->src);
 
         if (l->expect_header_name && c == '"') {
@@ -221,20 +266,10 @@ static void do_tokenize_all(Lexer* l) {
             if (infile_consume_if(l->src, '=')) {
                 tok->kind = TokenKind_assign_div;
             } else if (infile_consume_if(l->src, '/')) {
-                while (!infile_eof(l->src) && infile_peek_char(l->src) != '\n') {
-                    infile_next_char(l->src);
-                }
+                skip_line_comment(l->src);
                 tok->kind = TokenKind_whitespace;
             } else if (infile_consume_if(l->src, '*')) {
-                while (infile_peek_char(l->src)) {
-                    if (infile_consume_if(l->src, '*')) {
-                        if (infile_consume_if(l->src, '/')) {
-                            break;
-                        }
-                        continue;
-                    }
-                    infile_next_char(l->src);
-                }
+                skip_block_comment(l->src);
                 tok->kind = TokenKind_whitespace;
             } else {
                 tok->kind = TokenKind_slash;
@@ -329,9 +364,13 @@ static void do_tokenize_all(Lexer* l) {
             StrBuilder builder;
             strbuilder_init(&builder);
             while (1) {
+                append_raw(l->src, &builder, scan_string_body(infile_raw(l->src), infile_raw_end(l->src)));
                 char ch = infile_peek_char(l->src);
                 if (ch == '"')
                     break;
+                if (infile_eof(l->src)) {
+                    fatal_error("%s:%d: unterminated string literal", token_filename(tok), token_line(tok));
+                }
                 strbuilder_append_char(&builder, ch);
                 if (ch == '\\') {
                     infile_next_char(l->src);
@@ -346,10 +385,9 @@ static void do_tokenize_all(Lexer* l) {
             // TODO: implement tokenization of pp-number.
             StrBuilder builder;
             strbuilder_init(&builder);
-            while (isalnum(infile_peek_char(l->src))) {
-                strbuilder_append_char(&builder, infile_peek_char(l->src));
-                infile_next_char(l->src);
-            }
+            do {
+                append_raw(l->src, &builder, scan_alnum(infile_raw(l->src), infile_raw_end(l->src)));
+            } while (isalnum(infile_peek_char(l->src)));
             if (infile_peek_char(l->src) == '.' && isdigit(infile_peek_char2(l->src))) {
                 strbuilder_append_char(&builder, infile_peek_char(l->src));
                 infile_next_char(l->src);
@@ -364,14 +402,8 @@ static void do_tokenize_all(Lexer* l) {
                 tok->value.integer = strtol(builder.buf, NULL, 0);
             }
         } else if (isalpha(c) || c == '_') {
-            StrBuilder builder;
-            strbuilder_init(&builder);
-            while (isalnum(infile_peek_char(l->src)) || infile_peek_char(l->src) == '_') {
-                strbuilder_append_char(&builder, infile_peek_char(l->src));
-                infile_next_char(l->src);
-            }
             tok->kind = TokenKind_ident;
-            tok->value.string = builder.buf;
+            tok->value.string = read_identifier(l->src);
         } else if (c == '\n') {
             infile_next_char(l->src);
             tok->kind = TokenKind_newline;
@@ -386,8 +418,10 @@ static void do_tokenize_all(Lexer* l) {
             // reset, the next occurrence of '<' or '"' would be recognized as part of a header name.
             l->expect_header_name = false;
         } else if (isspace(c)) {
-            while (isspace((c = infile_peek_char(l->src)))) {
-                if (c == '\n')
+            while (1) {
+                skip_raw(l->src, scan_blank(infile_raw(l->src), infile_raw_end(l->src)));
+                c = infile_peek_char(l->src);
+                if (!isspace(c) || c == '\n')
                     break;
                 infile_next_char(l->src);
             }
@@ -400,68 +434,134 @@ static void do_tokenize_all(Lexer* l) {
         } else {
             infile_next_char(l->src);
             tok->kind = TokenKind_other;
-            char* buf = calloc(2, sizeof(char));
+            char* buf = arena_alloc(&token_arena, 2);
             buf[0] = c;
             tok->value.string = buf;
         }
         l->at_bol = tok->kind == TokenKind_newline;
+
+        // Whitespace and new-lines are folded into the next token.
+        if (tok->kind == TokenKind_whitespace) {
+            l->next_flags |= TokenFlag_leading_space;
+            tokens_pop(l->tokens);
+        } else if (tok->kind == TokenKind_newline) {
+            l->next_flags = TokenFlag_at_bol;
+            if (l->next_newlines < CHAR_MAX) {
+                ++l->next_newlines;
+            }
+            tokens_pop(l->tokens);
+        } else {
+            tok->flags = l->next_flags;
+            tok->newlines = l->next_newlines;
+            l->next_flags = 0;
+            l->next_newlines = 0;
+            return;
+        }
     }
     Token* eof_tok = tokens_push_new(l->tokens);
-    eof_tok->loc = l->src->loc;
+    eof_tok->pos = infile_source_pos(l->src);
     eof_tok->kind = TokenKind_eof;
+    eof_tok->flags = l->next_flags;
+    eof_tok->newlines = l->next_newlines;
+    l->reached_eof = true;
+}
+
+int character_constant_value(const char* spelling) {
+    int ch = spelling[1];
+    if (ch == '\\') {
+        ch = spelling[2];
+        if (ch == 'a') {
+            ch = '\a';
+        } else if (ch == 'b') {
+            ch = '\b';
+        } else if (ch == 'f') {
+            ch = '\f';
+        } else if (ch == 'n') {
+            ch = '\n';
+        } else if (ch == 'r') {
+            ch = '\r';
+        } else if (ch == 't') {
+            ch = '\t';
+        } else if (ch == 'v') {
+            ch = '\v';
+        } else if (ch == '0') {
+            ch = '\0';
+        } else if (ch == 'e') {
+            // \e is not a part of Standard C, but commonly supported.
+            ch = 27;
+        }
+    }
+    return ch;
 }
 
-TokenArray* tokenize(InFile* src) {
-    Lexer* l = lexer_new(src);
-    do_tokenize_all(l);
-    return l->tokens;
+// Whether the #embed data at `pos` makes up whole elements of a braced initializer, i.e. it is between '{' or ',' and
+// ',' or '}', directly inside braces.
+static bool is_embedded_data_in_braced_list(TokenArray* pp_tokens, size_t pos, TokenArray* tokens,
+                                            IntArray* open_brackets) {
+    if (open_brackets->len == 0 || open_brackets->data[open_brackets->len - 1] != TokenKind_brace_l) {
+        return false;
+    }
+    if (tokens->len == 0) {
+        return false;
+    }
+    TokenKind prev = tokens->data[tokens->len - 1].kind;
+    if (prev != TokenKind_brace_l && prev != TokenKind_comma) {
+        return false;
+    }
+    for (size_t i = pos + 1; i < pp_tokens->len; ++i) {
+        TokenKind next = pp_tokens->data[i].kind;
+        if (next != TokenKind_removed) {
+            return next == TokenKind_brace_r || next == TokenKind_comma;
+        }
+    }
+    return false;
 }
 
 TokenArray* convert_pp_tokens_to_tokens(TokenArray* pp_tokens) {
     TokenArray* tokens = calloc(1, sizeof(TokenArray));
-    // tokens need not store whitespace tokens.
-    tokens_init(tokens, pp_tokens->len / 2);
+    tokens_init(tokens, pp_tokens->len);
+    // Kinds of the brackets that are open, to tell where #embed data is.
+    IntArray open_brackets;
+    ints_init(&open_brackets);
 
     for (size_t pos = 0; pos < pp_tokens->len; ++pos) {
         Token* pp_tok = &pp_tokens->data[pos];
         TokenKind k = pp_tok->kind;
-        if (k == TokenKind_removed || k == TokenKind_whitespace || k == TokenKind_newline) {
+        if (k == TokenKind_removed) {
+            continue;
+        }
+        if (k == TokenKind_paren_l || k == TokenKind_bracket_l || k == TokenKind_brace_l) {
+            ints_push(&open_brackets, k);
+        } else if ((k == TokenKind_paren_r || k == TokenKind_bracket_r || k == TokenKind_brace_r) &&
+                   open_brackets.len > 0) {
+            --open_brackets.len;
+        }
+        if (k == TokenKind_embedded_data && !is_embedded_data_in_braced_list(pp_tokens, pos, tokens, &open_brackets)) {
+            // Anywhere else, the data is spelled out as integer constants.
+            const EmbeddedData* embedded = pp_tok->value.embedded_data;
+            for (size_t i = 0; i < embedded->len; ++i) {
+                if (i > 0) {
+                    Token* comma = tokens_push_new(tokens);
+                    comma->kind = TokenKind_comma;
+                    comma->pos = pp_tok->pos;
+                }
+                Token* tok = tokens_push_new(tokens);
+                tok->kind = TokenKind_literal_int;
+                tok->value.integer = embedded->data[i] & 0xff;
+                tok->pos = pp_tok->pos;
+            }
             continue;
         }
         Token* tok = tokens_push_new(tokens);
-        tok->loc = pp_tok->loc;
+        tok->pos = pp_tok->pos;
         if (k == TokenKind_character_constant) {
             tok->kind = TokenKind_literal_int;
-            int ch = pp_tok->value.string[1];
-            if (ch == '\\') {
-                ch = pp_tok->value.string[2];
-                if (ch == 'a') {
-                    ch = '\a';
-                } else if (ch == 'b') {
-                    ch = '\b';
-                } else if (ch == 'f') {
-                    ch = '\f';
-                } else if (ch == 'n') {
-                    ch = '\n';
-                } else if (ch == 'r') {
-                    ch = '\r';
-                } else if (ch == 't') {
-                    ch = '\t';
-                } else if (ch == 'v') {
-                    ch = '\v';
-                } else if (ch == '0') {
-                    ch = '\0';
-                } else if (ch == 'e') {
-                    // \e is not a part of Standard C, but commonly supported.
-                    ch = 27;
-                }
-            }
-            tok->value.integer = ch;
+            tok->value.integer = character_constant_value(pp_tok->value.string);
         } else if (k == TokenKind_literal_str) {
             tok->kind = pp_tok->kind;
 
             size_t len = strlen(pp_tok->value.string);
-            char* buf = calloc(len + 1, sizeof(char));
+            char* buf = arena_alloc(&token_arena, len + 1);
             for (size_t i = 0, j = 0; i < len; i++, j++) {
                 if (pp_tok->value.string[i] == '\\' && pp_tok->value.string[i + 1] == 'e') {
                     // \e is not a part of Standard C, but commonly supported.
@@ -473,116 +573,8 @@ TokenArray* convert_pp_tokens_to_tokens(TokenArray* pp_tokens) {
             }
             tok->value.string = buf;
         } else if (k == TokenKind_ident) {
-            if (strcmp(pp_tok->value.string, "alignas") == 0) {
-                tok->kind = TokenKind_keyword_alignas;
-            } else if (strcmp(pp_tok->value.string, "alignof") == 0) {
-                tok->kind = TokenKind_keyword_alignof;
-            } else if (strcmp(pp_tok->value.string, "auto") == 0) {
-                tok->kind = TokenKind_keyword_auto;
-            } else if (strcmp(pp_tok->value.string, "bool") == 0) {
-                tok->kind = TokenKind_keyword_bool;
-            } else if (strcmp(pp_tok->value.string, "break") == 0) {
-                tok->kind = TokenKind_keyword_break;
-            } else if (strcmp(pp_tok->value.string, "case") == 0) {
-                tok->kind = TokenKind_keyword_case;
-            } else if (strcmp(pp_tok->value.string, "char") == 0) {
-                tok->kind = TokenKind_keyword_char;
-            } else if (strcmp(pp_tok->value.string, "const") == 0) {
-                tok->kind = TokenKind_keyword_const;
-            } else if (strcmp(pp_tok->value.string, "constexpr") == 0) {
-                tok->kind = TokenKind_keyword_constexpr;
-            } else if (strcmp(pp_tok->value.string, "continue") == 0) {
-                tok->kind = TokenKind_keyword_continue;
-            } else if (strcmp(pp_tok->value.string, "default") == 0) {
-                tok->kind = TokenKind_keyword_default;
-            } else if (strcmp(pp_tok->value.string, "do") == 0) {
-                tok->kind = TokenKind_keyword_do;
-            } else if (strcmp(pp_tok->value.string, "double") == 0) {
-                tok->kind = TokenKind_keyword_double;
-            } else if (strcmp(pp_tok->value.string, "else") == 0) {
-                tok->kind = TokenKind_keyword_else;
-            } else if (strcmp(pp_tok->value.string, "enum") == 0) {
-                tok->kind = TokenKind_keyword_enum;
-            } else if (strcmp(pp_tok->value.string, "extern") == 0) {
-                tok->kind = TokenKind_keyword_extern;
-            } else if (strcmp(pp_tok->value.string, "false") == 0) {
-                tok->kind = TokenKind_keyword_false;
-            } else if (strcmp(pp_tok->value.string, "float") == 0) {
-                tok->kind = TokenKind_keyword_float;
-            } else if (strcmp(pp_tok->value.string, "for") == 0) {
-                tok->kind = TokenKind_keyword_for;
-            } else if (strcmp(pp_tok->value.string, "goto") == 0) {
-                tok->kind = TokenKind_keyword_goto;
-            } else if (strcmp(pp_tok->value.string, "if") == 0) {
-                tok->kind = TokenKind_keyword_if;
-            } else if (strcmp(pp_tok->value.string, "inline") == 0) {
-                tok->kind = TokenKind_keyword_inline;
-            } else if (strcmp(pp_tok->value.string, "int") == 0) {
-                tok->kind = TokenKind_keyword_int;
-            } else if (strcmp(pp_tok->value.string, "long") == 0) {
-                tok->kind = TokenKind_keyword_long;
-            } else if (strcmp(pp_tok->value.string, "nullptr") == 0) {
-                tok->kind = TokenKind_keyword_nullptr;
-            } else if (strcmp(pp_tok->value.string, "register") == 0) {
-                tok->kind = TokenKind_keyword_register;
-            } else if (strcmp(pp_tok->value.string, "restrict") == 0) {
-                tok->kind = TokenKind_keyword_restrict;
-            } else if (strcmp(pp_tok->value.string, "return") == 0) {
-                tok->kind = TokenKind_keyword_return;
-            } else if (strcmp(pp_tok->value.string, "short") == 0) {
-                tok->kind = TokenKind_keyword_short;
-            } else if (strcmp(pp_tok->value.string, "signed") == 0) {
-                tok->kind = TokenKind_keyword_signed;
-            } else if (strcmp(pp_tok->value.string, "sizeof") == 0) {
-                tok->kind = TokenKind_keyword_sizeof;
-            } else if (strcmp(pp_tok->value.string, "static") == 0) {
-                tok->kind = TokenKind_keyword_static;
-            } else if (strcmp(pp_tok->value.string, "static_assert") == 0) {
-                tok->kind = TokenKind_keyword_static_assert;
-            } else if (strcmp(pp_tok->value.string, "struct") == 0) {
-                tok->kind = TokenKind_keyword_struct;
-            } else if (strcmp(pp_tok->value.string, "switch") == 0) {
-                tok->kind = TokenKind_keyword_switch;
-            } else if (strcmp(pp_tok->value.string, "thread_local") == 0) {
-                tok->kind = TokenKind_keyword_thread_local;
-            } else if (strcmp(pp_tok->value.string, "true") == 0) {
-                tok->kind = TokenKind_keyword_true;
-            } else if (strcmp(pp_tok->value.string, "typedef") == 0) {
-                tok->kind = TokenKind_keyword_typedef;
-            } else if (strcmp(pp_tok->value.string, "typeof") == 0) {
-                tok->kind = TokenKind_keyword_typeof;
-            } else if (strcmp(pp_tok->value.string, "typeof_unqual") == 0) {
-                tok->kind = TokenKind_keyword_typeof_unqual;
-            } else if (strcmp(pp_tok->value.string, "union") == 0) {
-                tok->kind = TokenKind_keyword_union;
-            } else if (strcmp(pp_tok->value.string, "unsigned") == 0) {
-                tok->kind = TokenKind_keyword_unsigned;
-            } else if (strcmp(pp_tok->value.string, "void") == 0) {
-                tok->kind = TokenKind_keyword_void;
-            } else if (strcmp(pp_tok->value.string, "volatile") == 0) {
-                tok->kind = TokenKind_keyword_volatile;
-            } else if (strcmp(pp_tok->value.string, "while") == 0) {
-                tok->kind = TokenKind_keyword_while;
-            } else if (strcmp(pp_tok->value.string, "_Atomic") == 0) {
-                tok->kind = TokenKind_keyword__Atomic;
-            } else if (strcmp(pp_tok->value.string, "_BitInt") == 0) {
-                tok->kind = TokenKind_keyword__BitInt;
-            } else if (strcmp(pp_tok->value.string, "_Complex") == 0) {
-                tok->kind = TokenKind_keyword__Complex;
-            } else if (strcmp(pp_tok->value.string, "_Decimal128") == 0) {
-                tok->kind = TokenKind_keyword__Decimal128;
-            } else if (strcmp(pp_tok->value.string, "_Decimal32") == 0) {
-                tok->kind = TokenKind_keyword__Decimal32;
-            } else if (strcmp(pp_tok->value.string, "_Decimal64") == 0) {
-                tok->kind = TokenKind_keyword__Decimal64;
-            } else if (strcmp(pp_tok->value.string, "_Generic") == 0) {
-                tok->kind = TokenKind_keyword__Generic;
-            } else if (strcmp(pp_tok->value.string, "_Imaginary") == 0) {
-                tok->kind = TokenKind_keyword__Imaginary;
-            } else if (strcmp(pp_tok->value.string, "_Noreturn") == 0) {
-                tok->kind = TokenKind_keyword__Noreturn;
-            } else {
-                tok->kind = TokenKind_ident;
+            tok->kind = atom_keyword_kind(pp_tok->value.string);
+            if (tok->kind == TokenKind_ident) {
                 tok->value = pp_tok->value;
             }
         } else if (k == TokenKind_other) {
@@ -595,3 +587,80 @@ TokenArray* convert_pp_tokens_to_tokens(TokenArray* pp_tokens) {
 
     return tokens;
 }
+
+bool lexer_at_line_end(Lexer* l) {
+    if (l->at_bol) {
+        return true;
+    }
+    InFile* src = l->src;
+    while (1) {
+        char c = infile_peek_char(src);
+        if (c == '/' && infile_peek_char2(src) == '/') {
+            infile_next_char(src);
+            infile_next_char(src);
+            skip_line_comment(src);
+        } else if (c == '/' && infile_peek_char2(src) == '*') {
+            infile_next_char(src);
+            infile_next_char(src);
+            skip_block_comment(src);
+        } else if (isspace(c) && c != '\n') {
+            infile_next_char(src);
+        } else {
+            break;
+        }
+        // As in lexer_next(), the skipped blanks and comments are folded into the next token.
+        l->next_flags |= TokenFlag_leading_space;
+    }
+    return infile_eof(src) || infile_peek_char(src) == '\n';
+}
+
+SourcePos lexer_skip_to_next_directive(Lexer* l) {
+    InFile* src = l->src;
+    SourcePos next_line_pos = 0;
+    while (!infile_eof(src)) {
+        // The rest of the line. Comments and literals are followed so that a new-line or a '#' inside them is not taken
+        // for the start of a directive.
+        while (!infile_eof(src)) {
+            skip_raw(src, scan_skipped_text(infile_raw(src), infile_raw_end(src)));
+            char c = infile_peek_char(src);
+            if (c == '\n') {
+                break;
+            }
+            infile_next_char(src);
+            if (c == '/') {
+                if (infile_consume_if(src, '/')) {
+                    skip_line_comment(src);
+                } else if (infile_consume_if(src, '*')) {
+                    skip_block_comment(src);
+                }
+            } else if (c == '"' || c == '\'') {
+                skip_quoted(src, c);
+            }
+        }
+        if (infile_eof(src)) {
+            break;
+        }
+        infile_next_char(src);
+        if (next_line_pos == 0) {
+            next_line_pos = infile_source_pos(src);
+        }
+
+        // As in lexer_next(), only blanks may come before the '#' of a directive.
+        while (1) {
+            skip_raw(src, scan_blank(infile_raw(src), infile_raw_end(src)));
+            char c = infile_peek_char(src);
+            if (!isspace(c) || c == '\n')
+                break;
+            infile_next_char(src);
+        }
+        if (infile_peek_char(src) == '#') {
+            break;
+        }
+    }
+
+    l->at_bol = true;
+    l->expect_header_name = false;
+    l->next_flags = TokenFlag_at_bol;
+    l->next_newlines = 0;
+    return next_line_pos != 0 ? next_line_pos : infile_source_pos(src);
+}
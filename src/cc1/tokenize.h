@@ -4,7 +4,30 @@
 #include "io.h"
 #include "token.h"
 
-TokenArray* tokenize(InFile* src);
+typedef struct {
+    InFile* src;
+    bool at_bol;
+    bool expect_header_name;
+    // Flags and new-line count for the next token, gathered from the whitespace and new-lines before it.
+    int next_flags;
+    int next_newlines;
+    // Tokens are appended here one at a time, as the caller asks for them.
+    TokenArray* tokens;
+    bool reached_eof;
+} Lexer;
+
+Lexer* lexer_new(InFile* src, TokenArray* tokens);
+// Appends the next token to the lexer's token array. The last one is the EOF token; nothing is appended after it.
+void lexer_next(Lexer* l);
+// Whether the current line has no more tokens, i.e. only blanks and comments are left before its new-line. Unlike
+// looking at the next token, this does not lex the next line.
+bool lexer_at_line_end(Lexer* l);
+// Skips the rest of the current line and every following line up to the next one that starts with '#', or to the end
+// of input, without making any tokens. Used for the lines of a skipped conditional group. None of the skipped new-lines
+// are counted for the next token. Returns the position of the start of the line after the current one.
+SourcePos lexer_skip_to_next_directive(Lexer* l);
+// Returns the value of a character constant, given its spelling including the quotes.
+int character_constant_value(const char* spelling);
 TokenArray* convert_pp_tokens_to_tokens(TokenArray* pp_tokens);
 
 #endif
@@ -15,9 +15,24 @@ CliArgs* parse_cli_args(int argc, char** argv) {
     bool opt_c = false;
     bool opt_E = false;
     bool opt_wasm = false;
+    bool opt_M = false;
+    bool opt_MM = false;
     bool opt_MD = false;
     bool opt_MMD = false;
+    bool opt_MP = false;
+    const char* deps_filename = NULL;
+    StrBuilder deps_target;
+    strbuilder_init(&deps_target);
     bool opt_g = false;
+    bool opt_scalar_lexer = false;
+    bool opt_line_markers = false;
+    bool opt_debug_macro_stats = false;
+    bool opt_debug_arena_stats = false;
+    bool opt_debug_source_cache_stats = false;
+    bool opt_pp_report = false;
+    bool opt_pp_report_json = false;
+    bool opt_precompile_header = false;
+    const char* include_pch = NULL;
     StrArray include_dirs;
     strings_init(&include_dirs);
     StrArray defines;
@@ -39,8 +54,40 @@ CliArgs* parse_cli_args(int argc, char** argv) {
             // ignore
         } else if (c == 'W') {
             // ignore
-        } else if (c == 'M' && argv[i][2] == '\0') {
-            // ignore -M
+        } else if (strcmp(argv[i], "-M") == 0) {
+            opt_M = true;
+        } else if (strcmp(argv[i], "-MM") == 0) {
+            opt_MM = true;
+        } else if (strcmp(argv[i], "-MP") == 0) {
+            opt_MP = true;
+        } else if (str_starts_with(argv[i], "-MF")) {
+            if (argv[i][3] != '\0') {
+                // -MFfile format
+                deps_filename = argv[i] + 3;
+            } else if (argc > i + 1) {
+                // -MF file format
+                deps_filename = argv[i + 1];
+                ++i;
+            } else {
+                fatal_error("-MF requires filename");
+            }
+        } else if (str_starts_with(argv[i], "-MT")) {
+            const char* target = NULL;
+            if (argv[i][3] != '\0') {
+                // -MTtarget format
+                target = argv[i] + 3;
+            } else if (argc > i + 1) {
+                // -MT target format
+                target = argv[i + 1];
+                ++i;
+            } else {
+                fatal_error("-MT requires target");
+            }
+            // Multiple -MT options make a rule with multiple targets.
+            if (deps_target.len > 0) {
+                strbuilder_append_char(&deps_target, ' ');
+            }
+            strbuilder_append_string(&deps_target, target);
         } else if (c == 'I') {
             const char* dir = NULL;
             if (argv[i][2] != '\0') {
@@ -67,6 +114,22 @@ CliArgs* parse_cli_args(int argc, char** argv) {
                 fatal_error("-D requires macro definition");
             }
             strings_push(&defines, def);
+        } else if (strcmp(argv[i], "-x") == 0) {
+            if (argc <= i + 1) {
+                fatal_error("-x requires language");
+            }
+            if (strcmp(argv[i + 1], "c-header") == 0) {
+                opt_precompile_header = true;
+            } else if (strcmp(argv[i + 1], "c") != 0) {
+                fatal_error("unsupported language: %s", argv[i + 1]);
+            }
+            ++i;
+        } else if (strcmp(argv[i], "-include-pch") == 0) {
+            if (argc <= i + 1) {
+                fatal_error("-include-pch requires filename");
+            }
+            include_pch = argv[i + 1];
+            ++i;
         } else if (c == 'o') {
             if (argc <= i + 1) {
                 fatal_error("-o requires filename");
@@ -90,6 +153,21 @@ CliArgs* parse_cli_args(int argc, char** argv) {
             // ignore -std=*
         } else if (strcmp(argv[i], "--wasm") == 0) {
             opt_wasm = true;
+        } else if (strcmp(argv[i], "--scalar-lexer") == 0) {
+            opt_scalar_lexer = true;
+        } else if (strcmp(argv[i], "--line-markers") == 0) {
+            opt_line_markers = true;
+        } else if (strcmp(argv[i], "--debug-macro-stats") == 0) {
+            opt_debug_macro_stats = true;
+        } else if (strcmp(argv[i], "--debug-arena-stats") == 0) {
+            opt_debug_arena_stats = true;
+        } else if (strcmp(argv[i], "--debug-source-cache-stats") == 0) {
+            opt_debug_source_cache_stats = true;
+        } else if (strcmp(argv[i], "--pp-report") == 0) {
+            opt_pp_report = true;
+        } else if (strcmp(argv[i], "--pp-report=json") == 0) {
+            opt_pp_report = true;
+            opt_pp_report_json = true;
         } else {
             fatal_error("unknown option: %s", argv[i]);
         }
@@ -107,9 +185,22 @@ CliArgs* parse_cli_args(int argc, char** argv) {
     a->totally_deligate_to_gcc = false;
     a->wasm = opt_wasm;
     a->gcc_command = NULL;
-    a->generate_system_deps = opt_MD;
-    a->generate_user_deps = opt_MD || opt_MMD;
+    a->generate_system_deps = opt_M || opt_MD;
+    a->generate_user_deps = opt_M || opt_MM || opt_MD || opt_MMD;
+    a->deps_only = opt_M || opt_MM;
+    a->deps_filename = deps_filename;
+    a->deps_target = deps_target.len > 0 ? deps_target.buf : NULL;
+    a->deps_phony_targets = opt_MP;
     a->generate_debug_info = opt_g;
+    a->scalar_lexer = opt_scalar_lexer;
+    a->line_markers = opt_line_markers;
+    a->debug_macro_stats = opt_debug_macro_stats;
+    a->debug_arena_stats = opt_debug_arena_stats;
+    a->debug_source_cache_stats = opt_debug_source_cache_stats;
+    a->pp_report = opt_pp_report;
+    a->pp_report_json = opt_pp_report_json;
+    a->precompile_header = opt_precompile_header;
+    a->include_pch = include_pch;
     a->include_dirs = include_dirs;
     a->defines = defines;
 
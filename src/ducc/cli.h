@@ -11,9 +11,34 @@ typedef struct {
     bool preprocess_only;
     bool generate_system_deps;
     bool generate_user_deps;
+    // -M or -MM: write the dependencies of the input instead of compiling it.
+    bool deps_only;
+    // -MF: the file the dependencies are written to.
+    const char* deps_filename;
+    // -MT: the target of the dependency rule, instead of the object file.
+    const char* deps_target;
+    // -MP: add an empty rule for each header, so that make does not fail when it is removed.
+    bool deps_phony_targets;
     bool generate_debug_info;
     bool totally_deligate_to_gcc;
     bool wasm;
+    // Use the byte-at-a-time scanning kernels in the lexer instead of the SWAR ones.
+    bool scalar_lexer;
+    // With -E, write # <line> "<file>" markers so that the output can be mapped back to the source.
+    bool line_markers;
+    // Print statistics of the preprocessor's macro table to stderr.
+    bool debug_macro_stats;
+    // Print the peak and total bytes of each allocation arena to stderr.
+    bool debug_arena_stats;
+    // Print the hits and misses of the source file cache to stderr.
+    bool debug_source_cache_stats;
+    // --pp-report: print where the preprocessor's time goes to stderr, as text or, with --pp-report=json, as JSON.
+    bool pp_report;
+    bool pp_report_json;
+    // -x c-header: write the preprocessor's state after the input to a precompiled header, and do nothing else.
+    bool precompile_header;
+    // -include-pch: restore the state saved in this precompiled header before preprocessing the input.
+    const char* include_pch;
     const char* gcc_command;
     StrArray include_dirs;
     StrArray defines;
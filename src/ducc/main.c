@@ -1,14 +1,53 @@
+#include <libgen.h>
 #include "../cc1/ast.h"
 #include "../cc1/codegen.h"
 #include "../cc1/codegen_wasm.h"
 #include "../cc1/fs.h"
 #include "../cc1/io.h"
 #include "../cc1/parse.h"
+#include "../cc1/pp_report.h"
 #include "../cc1/preprocess.h"
+#include "../cc1/scan.h"
 #include "../cc1/tokenize.h"
+#include "../lib/arena.h"
 #include "../lib/common.h"
 #include "cli.h"
 
+// Writes a make rule for `target`, which depends on the input and the files it includes. With `phony_targets`, an empty
+// rule is added for each included file, so that make does not fail after the file is removed.
+static void write_deps(const char* filename, const char* target, StrArray* included_files, bool phony_targets) {
+    FILE* dep_file = filename ? fopen(filename, "w") : stdout;
+    if (!dep_file) {
+        fatal_error("Cannot open dependency file: %s", filename);
+    }
+    fprintf(dep_file, "%s:", target);
+    for (size_t i = 0; i < included_files->len; ++i) {
+        // Built-in headers have no file on disk to depend on.
+        if (infile_is_builtin(included_files->data[i])) {
+            continue;
+        }
+        fprintf(dep_file, " \\\n    %s", included_files->data[i]);
+    }
+    fprintf(dep_file, "\n");
+    if (phony_targets) {
+        // The input comes first and gets no rule.
+        for (size_t i = 1; i < included_files->len; ++i) {
+            if (infile_is_builtin(included_files->data[i])) {
+                continue;
+            }
+            fprintf(dep_file, "\n%s:\n", included_files->data[i]);
+        }
+    }
+    if (filename) {
+        fclose(dep_file);
+    }
+}
+
+// The object file gcc would make from the input: its base name, with the extension replaced by .o.
+static const char* default_deps_target(const char* input_filename) {
+    return replace_extension(basename(strdup(input_filename)), ".o");
+}
+
 int main(int argc, char** argv) {
     CliArgs* cli_args = parse_cli_args(argc, argv);
 
@@ -16,20 +55,76 @@ int main(int argc, char** argv) {
         return system(cli_args->gcc_command);
     }
 
+    if (cli_args->scalar_lexer) {
+        scan_set_kernel(ScanKernel_scalar);
+    }
+    if (cli_args->pp_report) {
+        pp_report_enable();
+    }
+
+    // The precompiled header reopens its source files, which must be the first ones opened.
+    PrecompiledHeader* pch = NULL;
+    if (cli_args->include_pch) {
+        pch = pch_load(cli_args->include_pch, &cli_args->defines, &cli_args->include_dirs);
+    }
+
     InFile* source = infile_open(cli_args->input_filename);
 
     StrArray included_files;
     strings_init(&included_files);
 
-    TokenArray* pp_tokens = preprocess(source, &cli_args->defines, &cli_args->include_dirs, &included_files,
-                                       cli_args->generate_system_deps, cli_args->generate_user_deps);
+    const char* pch_output_filename = NULL;
+    if (cli_args->precompile_header) {
+        if (cli_args->output_filename) {
+            pch_output_filename = cli_args->output_filename;
+        } else {
+            char* buf = calloc(strlen(cli_args->input_filename) + strlen(".pch") + 1, sizeof(char));
+            sprintf(buf, "%s.pch", cli_args->input_filename);
+            pch_output_filename = buf;
+        }
+    }
+    TokenArray* pp_tokens =
+        preprocess(source, &cli_args->defines, &cli_args->include_dirs, &included_files, cli_args->generate_system_deps,
+                   cli_args->generate_user_deps, cli_args->deps_only, pch, pch_output_filename);
+
+    if (cli_args->debug_macro_stats) {
+        const MacroTableStats* stats = macro_table_stats();
+        long average_x100 = stats->lookups == 0 ? 0 : stats->probes * 100 / stats->lookups;
+        fprintf(stderr, "macro table: %d names in %d slots, %ld lookups, %ld.%02ld probes on average, %d at most\n",
+                stats->names, stats->index_capacity, stats->lookups, average_x100 / 100, average_x100 % 100,
+                stats->max_probes);
+        fprintf(stderr, "macro expansion cache: %ld expansions stored, %ld reused\n", stats->expansion_cache_stores,
+                stats->expansion_cache_hits);
+    }
+    if (cli_args->debug_source_cache_stats) {
+        const SourceCacheStats* stats = source_cache_stats();
+        fprintf(stderr, "source cache: %d hits, %d misses, %d invalidations\n", stats->hits, stats->misses,
+                stats->invalidations);
+    }
+    if (cli_args->pp_report) {
+        pp_report_count_output_tokens(pp_tokens);
+        pp_report_write(stderr, cli_args->pp_report_json);
+    }
+
+    if (cli_args->precompile_header) {
+        return 0;
+    }
+
+    if (cli_args->deps_only) {
+        // As with -E, -o names the output, which is the dependencies here.
+        const char* dep_filename = cli_args->deps_filename ? cli_args->deps_filename : cli_args->output_filename;
+        const char* target =
+            cli_args->deps_target ? cli_args->deps_target : default_deps_target(cli_args->input_filename);
+        write_deps(dep_filename, target, &included_files, cli_args->deps_phony_targets);
+        return 0;
+    }
 
     if (cli_args->preprocess_only) {
         FILE* output_file = cli_args->output_filename ? fopen(cli_args->output_filename, "w") : stdout;
         if (!output_file) {
             fatal_error("Cannot open output file: %s", cli_args->output_filename);
         }
-        print_token_to_file(output_file, pp_tokens);
+        print_token_to_file(output_file, pp_tokens, cli_args->line_markers);
         return 0;
     }
 
@@ -54,6 +149,10 @@ int main(int argc, char** argv) {
     }
     fclose(assembly_file);
 
+    if (cli_args->debug_arena_stats) {
+        arena_write_stats(stderr);
+    }
+
     if (cli_args->wasm) {
         return 0;
     }
@@ -72,17 +171,12 @@ int main(int argc, char** argv) {
     }
 
     if ((cli_args->generate_system_deps || cli_args->generate_user_deps) && cli_args->only_compile &&
-        cli_args->output_filename) {
-        const char* dep_filename = replace_extension(cli_args->output_filename, ".d");
-
-        FILE* dep_file = fopen(dep_filename, "w");
-        if (!dep_file) {
-            fatal_error("Cannot open dependency file: %s", dep_filename);
-        }
-        fprintf(dep_file, "%s:", cli_args->output_filename);
-        for (size_t i = 0; i < included_files.len; ++i) {
-            fprintf(dep_file, " \\\n    %s", included_files.data[i]);
-        }
-        fprintf(dep_file, "\n");
+        (cli_args->output_filename || cli_args->deps_filename)) {
+        const char* dep_filename = cli_args->deps_filename ? cli_args->deps_filename
+                                                           : replace_extension(cli_args->output_filename, ".d");
+        const char* target = cli_args->deps_target ? cli_args->deps_target
+                             : cli_args->output_filename ? cli_args->output_filename
+                                                         : default_deps_target(cli_args->input_filename);
+        write_deps(dep_filename, target, &included_files, cli_args->deps_phony_targets);
     }
 }
@@ -0,0 +1,92 @@
+#include "arena.h"
+#include "common.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT 16
+
+struct ArenaBlock {
+    ArenaBlock* prev;
+    char* data;
+    size_t used;
+    size_t capacity;
+};
+
+Arena token_arena;
+Arena parse_arena;
+Arena codegen_arena;
+
+static ArenaBlock* arena_block_new(ArenaBlock* prev, size_t capacity) {
+    ArenaBlock* block = calloc(1, sizeof(ArenaBlock));
+    block->prev = prev;
+    block->data = calloc(capacity, sizeof(char));
+    block->capacity = capacity;
+    return block;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    if (size == 0) {
+        size = ARENA_ALIGNMENT;
+    }
+    arena->bytes += size;
+    arena->total_bytes += size;
+    if (arena->peak_bytes < arena->bytes) {
+        arena->peak_bytes = arena->bytes;
+    }
+
+    if (!arena->block) {
+        arena->block = arena_block_new(NULL, ARENA_BLOCK_SIZE);
+    }
+    // A large allocation gets a block of its own, slipped in behind the current one so that the rest of the current
+    // block is not wasted.
+    if (ARENA_BLOCK_SIZE / 4 < size) {
+        ArenaBlock* block = arena_block_new(arena->block->prev, size);
+        block->used = size;
+        arena->block->prev = block;
+        return block->data;
+    }
+    if (arena->block->capacity < arena->block->used + size) {
+        arena->block = arena_block_new(arena->block, ARENA_BLOCK_SIZE);
+    }
+    void* p = arena->block->data + arena->block->used;
+    arena->block->used += size;
+    return p;
+}
+
+void* arena_calloc(Arena* arena, size_t count, size_t size) {
+    return arena_alloc(arena, count * size);
+}
+
+char* arena_strdup(Arena* arena, const char* s) {
+    size_t len = strlen(s);
+    char* copy = arena_alloc(arena, len + 1);
+    memcpy(copy, s, len);
+    return copy;
+}
+
+void arena_reset(Arena* arena) {
+    ArenaBlock* block = arena->block;
+    if (!block) {
+        return;
+    }
+    while (block->prev) {
+        ArenaBlock* prev = block->prev;
+        free(block->data);
+        free(block);
+        block = prev;
+    }
+    memset(block->data, 0, block->used);
+    block->used = 0;
+    arena->block = block;
+    arena->bytes = 0;
+}
+
+static void arena_write_stat(FILE* out, const char* name, Arena* arena) {
+    fprintf(out, "%s arena: %zu bytes at peak, %zu bytes in total\n", name, arena->peak_bytes, arena->total_bytes);
+}
+
+void arena_write_stats(FILE* out) {
+    arena_write_stat(out, "tokens", &token_arena);
+    arena_write_stat(out, "parse", &parse_arena);
+    arena_write_stat(out, "codegen", &codegen_arena);
+}
@@ -0,0 +1,37 @@
+#ifndef DUCC_ARENA_H
+#define DUCC_ARENA_H
+
+#include "ducc.h"
+
+struct ArenaBlock;
+typedef struct ArenaBlock ArenaBlock;
+
+// A region allocator. Allocations are bumped out of large blocks and are never freed one by one: arena_reset() releases
+// all of them at once.
+typedef struct {
+    // The block being filled. Each block links to the one filled before it.
+    ArenaBlock* block;
+    // The bytes allocated since the last reset, the most there have been, and all bytes ever allocated.
+    size_t bytes;
+    size_t peak_bytes;
+    size_t total_bytes;
+} Arena;
+
+// Tokens and the strings they refer to, which live until the end of the compilation.
+extern Arena token_arena;
+// AST nodes, types and the parser's strings, which live until the end of the compilation.
+extern Arena parse_arena;
+// Scratch memory for the code generator, reset after each function.
+extern Arena codegen_arena;
+
+// Returns `size` zeroed bytes, aligned for any type.
+void* arena_alloc(Arena* arena, size_t size);
+void* arena_calloc(Arena* arena, size_t count, size_t size);
+char* arena_strdup(Arena* arena, const char* s);
+// Releases everything allocated from `arena`. The first block is kept for reuse.
+void arena_reset(Arena* arena);
+
+// Prints the peak and total bytes of each arena.
+void arena_write_stats(FILE* out);
+
+#endif
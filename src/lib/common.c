@@ -13,6 +13,12 @@ void fatal_error(const char* msg, ...) {
     exit(1);
 }
 
+size_t hash_mix(size_t key, int bits) {
+    // 0x9e3779b9, built at runtime to keep the literal within the range of int.
+    size_t golden = ((size_t)0x9e37 << 16) | 0x79b9;
+    return ((key * golden) >> (32 - bits)) & (((size_t)1 << bits) - 1);
+}
+
 bool str_starts_with(const char* s, const char* prefix) {
     size_t l1 = strlen(s);
     size_t l2 = strlen(prefix);
@@ -59,6 +65,12 @@ void strbuilder_append_string(StrBuilder* b, const char* s) {
     }
 }
 
+void strbuilder_append_bytes(StrBuilder* b, const char* s, size_t len) {
+    strbuilder_reserve(b, b->len + len + 1);
+    memcpy(b->buf + b->len, s, len);
+    b->len += len;
+}
+
 void strings_init(StrArray* strings) {
     strings->len = 0;
     strings->capacity = 32;
@@ -86,3 +98,25 @@ void strings_pop(StrArray* strings) {
         strings->len--;
     }
 }
+
+void ints_init(IntArray* ints) {
+    ints->len = 0;
+    ints->capacity = 32;
+    ints->data = calloc(ints->capacity, sizeof(int));
+}
+
+void ints_reserve(IntArray* ints, size_t size) {
+    if (size <= ints->capacity)
+        return;
+    while (ints->capacity < size) {
+        ints->capacity *= 2;
+    }
+    ints->data = realloc(ints->data, ints->capacity * sizeof(int));
+    memset(ints->data + ints->len, 0, (ints->capacity - ints->len) * sizeof(int));
+}
+
+int ints_push(IntArray* ints, int value) {
+    ints_reserve(ints, ints->len + 1);
+    ints->data[ints->len] = value;
+    return ++ints->len;
+}
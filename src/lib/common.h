@@ -12,6 +12,10 @@ _Noreturn void fatal_error(const char* msg, ...);
 
 #define unimplemented() fatal_error("%s:%d: unimplemented", __FILE__, __LINE__)
 
+// Fibonacci hashing: the top `bits` bits of the low 32 bits of `key` times 2^32 divided by the golden ratio. Keys
+// that are close together, such as IDs handed out in order, are scattered over all of the 2^bits slots.
+size_t hash_mix(size_t key, int bits);
+
 bool str_starts_with(const char* s, const char* prefix);
 bool str_ends_with(const char* s, const char* suffix);
 
@@ -26,6 +30,7 @@ void strbuilder_init(StrBuilder* b);
 void strbuilder_reserve(StrBuilder* b, size_t size);
 void strbuilder_append_char(StrBuilder* b, int c);
 void strbuilder_append_string(StrBuilder* b, const char* s);
+void strbuilder_append_bytes(StrBuilder* b, const char* s, size_t len);
 
 typedef struct {
     size_t len;
@@ -38,4 +43,14 @@ void strings_reserve(StrArray* strings, size_t size);
 int strings_push(StrArray* strings, const char* str);
 void strings_pop(StrArray* strings);
 
+typedef struct {
+    size_t len;
+    size_t capacity;
+    int* data;
+} IntArray;
+
+void ints_init(IntArray* ints);
+void ints_reserve(IntArray* ints, size_t size);
+int ints_push(IntArray* ints, int value);
+
 #endif
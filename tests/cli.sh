@@ -78,3 +78,31 @@ EOF
 test_compile_error <<'EOF'
 int main() 123
 EOF
+
+# --debug-source-cache-stats
+cat > twice.h <<'EOF'
+int twice;
+EOF
+cat > foo.c <<'EOF'
+#include "twice.h"
+#include "./twice.h"
+int main() { return 0; }
+EOF
+"$ducc" --debug-source-cache-stats -E foo.c > /dev/null 2> output
+if [[ "$(cat output)" != "source cache: 1 hits, 2 misses, 0 invalidations" ]]; then
+    echo "unexpected source cache stats: $(cat output)" >&2
+    exit 1
+fi
+
+# --debug-arena-stats
+cat > foo.c <<'EOF'
+int f(int a, int b) { return a + b; }
+int main() { return f(1, 2) - 3; }
+EOF
+"$ducc" --debug-arena-stats -o foo.s foo.c 2> output
+for arena in tokens parse codegen; do
+    if ! grep -Eq "^$arena arena: [1-9][0-9]* bytes at peak, [1-9][0-9]* bytes in total$" output; then
+        echo "missing stats of the $arena arena" >&2
+        exit 1
+    fi
+done
@@ -71,3 +71,28 @@ test_compile_error <<'EOF'
 
 int main() {}
 EOF
+
+cat <<'EOF' > expected
+main.c:1: division by zero in #if expression
+EOF
+test_compile_error <<'EOF'
+#if 1 / 0
+#endif
+EOF
+
+cat <<'EOF' > expected
+main.c:1: unexpected ')' in #if expression
+EOF
+test_compile_error <<'EOF'
+#if (1 + 2))
+#endif
+EOF
+
+cat <<'EOF' > expected
+main.c:2: unexpected end of #elif expression
+EOF
+test_compile_error <<'EOF'
+#if 0
+#elif 1 +
+#endif
+EOF
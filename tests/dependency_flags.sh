@@ -0,0 +1,107 @@
+mkdir -p sub system
+cat <<'EOF' > system/system.h
+EOF
+cat <<'EOF' > header.h
+#pragma once
+#include "sub/guarded.h"
+#define ENABLED 1
+EOF
+cat <<'EOF' > sub/guarded.h
+#ifndef GUARDED_H
+#define GUARDED_H
+#include <system.h>
+#endif
+EOF
+cat <<'EOF' > main.c
+#include "header.h"
+#include "sub/guarded.h"
+#include "header.h"
+#if ENABLED
+#include "sub/enabled.h"
+#else
+#include "sub/disabled.h"
+#endif
+// Text lines are not expanded, so this does not have to compile.
+int main() { undefined_function(ENABLED); }
+EOF
+cat <<'EOF' > sub/enabled.h
+EOF
+
+# -MM lists each user header once, in the order they are first included
+cat <<'EOF' > expected
+main.o: \
+    main.c \
+    ./header.h \
+    ./sub/guarded.h \
+    ./sub/enabled.h
+EOF
+"$ducc" -I system -MM main.c > output
+diff -u expected output
+
+# -MF, -MT and -MP
+cat <<'EOF' > expected
+out/main.o main.d: \
+    main.c \
+    ./header.h \
+    ./sub/guarded.h \
+    ./sub/enabled.h
+
+./header.h:
+
+./sub/guarded.h:
+
+./sub/enabled.h:
+EOF
+"$ducc" -I system -MM -MP -MT out/main.o -MT main.d -MF main.d main.c
+diff -u expected main.d
+
+# -M lists system headers too
+cat <<'EOF' > expected
+main.o: \
+    main.c \
+    ./header.h \
+    ./sub/guarded.h \
+    system/system.h \
+    ./sub/enabled.h
+EOF
+"$ducc" -I system -M main.c > output
+diff -u expected output
+
+# -MMD writes the dependencies next to the object file
+cat <<'EOF' > main.c
+#include "header.h"
+int main() { return ENABLED - 1; }
+EOF
+cat <<'EOF' > expected
+main.o: \
+    main.c \
+    ./header.h \
+    ./sub/guarded.h
+EOF
+"$ducc" -I system -MMD -c -o main.o main.c
+diff -u expected main.d
+
+# -M lists the headers that #include_next reaches, once each
+mkdir -p d1 d2
+cat <<'EOF' > d1/x.h
+#include_next <x.h>
+EOF
+cat <<'EOF' > d2/x.h
+#pragma once
+EOF
+cat <<'EOF' > d2/y.h
+#include "x.h"
+EOF
+cat <<'EOF' > next.c
+#include <x.h>
+#include <y.h>
+EOF
+cat <<'EOF' > expected
+next.o: \
+    next.c \
+    d1/x.h \
+    d2/x.h \
+    d2/y.h
+EOF
+"$ducc" -I d1 -I d2 -M next.c > output
+diff -u expected output
@@ -0,0 +1,91 @@
+printf 'AB\0\377"\\z' > data.bin
+printf '' > empty.bin
+
+cat <<'EOF' > expected
+7 65 66 0 255 34 92 122
+5 1 65 66 0 9
+1 65 66 3
+1 7
+found empty not-found
+EOF
+test_diff <<'EOF'
+int printf(const char*, ...);
+
+const unsigned char bytes[] = {
+#embed "data.bin"
+};
+
+int ints[] = {1,
+#embed "data.bin" limit(3)
+    , 9};
+
+unsigned char fallback[] = {
+#embed "empty.bin" if_empty(7)
+};
+
+int main() {
+    printf("%d", (int)sizeof(bytes));
+    for (int i = 0; i < sizeof(bytes); ++i) {
+        printf(" %d", bytes[i] & 0xff);
+    }
+    printf("\n");
+    printf("%d %d %d %d %d %d\n", (int)(sizeof(ints) / sizeof(int)), ints[0], ints[1], ints[2], ints[3], ints[4]);
+
+    unsigned char local[4] = {
+#embed "data.bin" limit(2) suffix(, 3) prefix(1,) __if_empty__(0)
+    };
+    printf("%d %d %d %d\n", local[0], local[1], local[2], local[3]);
+    printf("%d %d\n", (int)sizeof(fallback), fallback[0]);
+
+#if __has_embed("data.bin") == __STDC_EMBED_FOUND__
+    printf("found ");
+#endif
+#if __has_embed("empty.bin") == __STDC_EMBED_EMPTY__ && __has_embed("data.bin" limit(0)) == __STDC_EMBED_EMPTY__
+    printf("empty ");
+#endif
+#if __has_embed("missing.bin") == __STDC_EMBED_NOT_FOUND__ && !__has_embed("data.bin" vendor::param)
+    printf("not-found\n");
+#endif
+}
+EOF
+
+cat <<'EOF' > expected
+int a [] = { 0,
+65,66,0,255,34,92,122
+, 1 };
+int b =
+65,66
+;
+EOF
+test_cpp <<'EOF'
+#define LIMIT 2
+int a[] = { 0,
+#embed "data.bin"
+, 1 };
+int b =
+#embed "data.bin" limit(LIMIT)
+;
+EOF
+
+cat <<'EOF' > expected
+main.c:1: cannot open embed resource: "missing.bin"
+EOF
+test_compile_error <<'EOF'
+#embed "missing.bin"
+EOF
+
+cat <<'EOF' > expected
+main.c:1: unsupported #embed parameter: vendor::param
+EOF
+test_compile_error <<'EOF'
+#embed "data.bin" vendor::param
+EOF
+
+cat <<'EOF' > expected
+#embed in initializer of array of aggregates is not supported
+EOF
+test_compile_error <<'EOF'
+struct S { long a, b, c; } arr[] = {
+#embed "data.bin"
+};
+EOF
@@ -213,3 +213,42 @@ int main() {
 #endif
 }
 EOF
+
+cat <<'EOF' > expected
+1 2 3 4 5 6 7 8
+EOF
+
+test_diff <<'EOF'
+int printf(const char*, ...);
+
+#define N 10
+#define BIG 0x7fffffff
+
+int main() {
+#if (N * 3 + 2) / 4 == 8 && N % 3 == 1 && -N < 0 && ~0 == -1 && (1 << 4 | 3) == 19
+    printf("1 ");
+#endif
+#if 0 && 1 / 0
+#elif 1 || N / 0
+    printf("2 ");
+#endif
+#if (N > 5 ? N : 0 / 0) == 10 && (0 ? 1 / 0 : 3) == 3
+    printf("3 ");
+#endif
+#if 'a' == 97 && '\n' == 10 && '\0' == 0 && L'\0' - 1 < 0
+    printf("4 ");
+#endif
+#if BIG + 1 > BIG && BIG * 4 / 4 == BIG
+    printf("5 ");
+#endif
+#if undefined_name == 0 && true && !false
+    printf("6 ");
+#endif
+#if 1 - 2 - 3 == -4 && 2 * 3 % 4 == 2 && 1 + 2 * 3 == 7 && !(1 == 2) != 0
+    printf("7 ");
+#endif
+#if (1 << 62) * 4 == 0 && -1 << 1 == -2
+    printf("8\n");
+#endif
+}
+EOF
@@ -187,3 +187,143 @@ test_exit_code 0 <<'EOF'
 
 int main() { 1 < 2; }
 EOF
+
+# nested includes inside conditional groups, with macros used across them
+cat <<'EOF' > inner.h
+#define INNER(x) (x * 10)
+enum { inner = INNER(OUTER) };
+EOF
+cat <<'EOF' > outer.h
+#define OUTER 4
+#if OUTER > 3
+#include "inner.h"
+enum { outer = inner + 2 };
+#endif
+EOF
+
+cat <<'EOF' > expected
+40 42 460
+EOF
+
+test_diff <<'EOF'
+int printf(const char*, ...);
+#define LIST X(inner) X(outer)
+#ifndef OUTER
+#include "outer.h"
+#endif
+#define X(v) + v
+int main() { printf("%d %d %d\n", inner, outer, INNER(0 LIST)); }
+EOF
+
+# include guards and #pragma once
+cat <<'EOF' > guarded.h
+#ifndef GUARDED_H
+#define GUARDED_H
+printf("guarded\n");
+#endif
+EOF
+cat <<'EOF' > once.h
+#pragma once
+printf("once\n");
+EOF
+cat <<'EOF' > guard_else.h
+#ifndef GUARD_ELSE_H
+#define GUARD_ELSE_H
+printf("if\n");
+#else
+printf("else\n");
+#endif
+EOF
+cat <<'EOF' > guard_trailer.h
+#ifndef GUARD_TRAILER_H
+#define GUARD_TRAILER_H
+#endif
+printf("trailer\n");
+EOF
+
+cat <<'EOF' > expected
+guarded
+guarded
+once
+if
+else
+trailer
+trailer
+EOF
+
+test_diff <<'EOF'
+int printf(const char*, ...);
+int main() {
+#include "guarded.h"
+#include "guarded.h"
+#undef GUARDED_H
+#include "guarded.h"
+#include "once.h"
+#include "./once.h"
+#include "guard_else.h"
+#include "guard_else.h"
+#include "guard_trailer.h"
+#include "guard_trailer.h"
+}
+EOF
+
+# __has_include, and #include_next continuing the search after the directory of the current file
+mkdir -p inc1 inc2
+cat <<'EOF' > inc1/wrapped.h
+#define FIRST 1
+#include_next <wrapped.h>
+EOF
+cat <<'EOF' > inc2/wrapped.h
+#define SECOND 2
+EOF
+
+cat <<'EOF' > expected
+1 2
+has wrapped.h
+has inc2/wrapped.h
+EOF
+
+cat <<'EOF' > main.c
+int printf(const char*, ...);
+#include <wrapped.h>
+int main() {
+    printf("%d %d\n", FIRST, SECOND);
+#if defined(__has_include) && __has_include(<wrapped.h>) && !__has_include(<missing.h>)
+    printf("has wrapped.h\n");
+#endif
+#if __has_include("inc2/wrapped.h") && !__has_include("missing.h")
+    printf("has inc2/wrapped.h\n");
+#endif
+}
+EOF
+"$ducc" -Iinc1 -Iinc2 -o a.out main.c
+./a.out > output
+diff -u expected output
+
+# built-in headers are compiled into the binary
+mkdir -p relocated
+cp "$ducc" relocated/ducc
+ducc=relocated/ducc
+
+cat <<'EOF2' > expected
+42
+EOF2
+
+test_diff <<'EOF2'
+#include <stdarg.h>
+#include <stddef.h>
+
+int printf(const char*, ...);
+
+int first(int n, ...) {
+    va_list args;
+    va_start(args, n);
+    int x = va_arg(args, int);
+    va_end(args);
+    return x;
+}
+
+int main() {
+    printf("%d\n", first(1, 42 + (int)offsetof(struct { int a; }, a)));
+}
+EOF2
@@ -9,3 +9,60 @@ test_diff <<'EOF'
 
 int main() {}
 EOF
+
+# comments and literals in a skipped group may hide a new-line or a '#'
+cat <<'EOF' > expected
+x = 1, line = 22
+EOF
+test_diff <<'EOF'
+int printf(const char*, ...);
+#if 0
+/*
+#else
+*/
+const char* s = "/* #endif";
+char c = '"'; #else
+  #if 1 /* nested
+#endif */
+#error "not an error"
+  #  endif
+// a line comment \
+#else
+don't stop at an unterminated quote
+#elif 1
+int x = 1;
+#else
+int x = 2;
+#endif
+
+int main() {
+    printf("x = %d, line = %d\n", x, __LINE__);
+}
+EOF
+
+# the first line of a skipped group is not lexed either
+cat <<'EOF' > expected
+z = 3
+EOF
+test_diff <<'EOF'
+int printf(const char*, ...);
+#ifdef X
+  "a
+#endif
+#if 1 + 1 == 3 // "b
+  'c
+#else /* " */
+int z = 3;
+#endif
+#ifndef __LINE__
+"d
+#elif 1
+int w;
+#elifdef __LINE__
+"e
+#endif
+
+int main() {
+    printf("z = %d\n", z);
+}
+EOF
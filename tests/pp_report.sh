@@ -0,0 +1,51 @@
+cat <<'EOF' > inner.h
+#ifndef INNER_H
+#define INNER_H
+#define TWICE(x) x x
+#if 0
+skipped
+skipped
+#endif
+int inner;
+#endif
+EOF
+cat <<'EOF' > outer.h
+#include "inner.h"
+#define ONE 1
+EOF
+cat <<'EOF' > main.c
+#include "outer.h"
+#include "inner.h"
+int a = ONE + ONE;
+int b = TWICE(ONE);
+EOF
+
+# the times vary from run to run
+cat <<'EOF' > expected
+{"files":[{"file":"main.c","includes":1,"guarded_includes":0,"total_us":0,"self_us":0,"output_tokens":13,"skipped_lines":0},{"file":"./outer.h","includes":1,"guarded_includes":0,"total_us":0,"self_us":0,"output_tokens":0,"skipped_lines":0},{"file":"./inner.h","includes":1,"guarded_includes":1,"total_us":0,"self_us":0,"output_tokens":3,"skipped_lines":2}],"macros_by_expansions":[{"name":"ONE","expansions":3,"expanded_tokens":3},{"name":"TWICE","expansions":1,"expanded_tokens":2}],"macros_by_expanded_tokens":[{"name":"ONE","expansions":3,"expanded_tokens":3},{"name":"TWICE","expansions":1,"expanded_tokens":2}],"include_chains":[["main.c","./outer.h","./inner.h"]]}
+EOF
+"$ducc" --pp-report=json -E main.c 2>&1 > /dev/null | sed -E 's/"(total|self)_us":[0-9]+/"\1_us":0/g' > output
+diff -u expected output
+
+"$ducc" --pp-report -E main.c 2> output > /dev/null
+for heading in "files by total time:" "macros by expansions:" "macros by expanded tokens:" \
+    "deepest include chains:"; do
+    if ! grep -qx "$heading" output; then
+        echo "missing '$heading'" >&2
+        exit 1
+    fi
+done
+grep -q '^  3: main.c -> ./outer.h -> ./inner.h$' output
+
+# a file reached by two names is one entry, under the first name
+mkdir -p sub
+cat <<'EOF' > twice.c
+#include "inner.h"
+#include "sub/../inner.h"
+EOF
+"$ducc" --pp-report=json -E twice.c 2> output > /dev/null
+grep -q '{"file":"./inner.h","includes":1,"guarded_includes":1,' output
+if grep -q 'sub/' output; then
+    echo "inner.h is listed twice" >&2
+    exit 1
+fi
@@ -0,0 +1,86 @@
+cat <<'EOF' > prelude.h
+#ifndef PRELUDE_H
+#define PRELUDE_H
+#include <stddef.h>
+int printf(const char*, ...);
+#define SQUARE(x) ((x) * (x))
+#define GREETING "hello"
+struct point {
+    int x;
+    int y;
+};
+static int add(int a, int b) {
+    return a + b;
+}
+#endif
+EOF
+
+cat <<'EOF' > main.c
+#include "prelude.h"
+int main() {
+    struct point p = {SQUARE(3), add(2, 3)};
+    printf("%s %d %d %d\n", GREETING, p.x, p.y, (int)offsetof(struct point, y));
+}
+EOF
+
+cat <<'EOF' > expected
+hello 9 5 4
+EOF
+
+# the state after the header is restored instead of preprocessing it again
+"$ducc" -x c-header -o prelude.h.pch prelude.h
+"$ducc" -include-pch prelude.h.pch -o a.out main.c
+./a.out > output
+diff -u expected output
+
+# -E output is the same as without the precompiled header
+"$ducc" -E main.c > expected
+"$ducc" -include-pch prelude.h.pch -E main.c > output
+diff -u expected output
+
+# the precompiled header is rejected if the options or the header changed
+cat <<'EOF' > expected
+prelude.h.pch: precompiled header was built with different -D options
+EOF
+set +e
+"$ducc" -DFOO -include-pch prelude.h.pch main.c > /dev/null 2> output
+exit_code=$?
+set -e
+if [[ $exit_code -eq 0 ]]; then
+    echo "expected to fail" >&2
+    exit 1
+fi
+diff -u expected output
+
+touch -d '2000-01-01' prelude.h
+cat <<'EOF' > expected
+prelude.h.pch: precompiled header is out of date, prelude.h has changed
+EOF
+set +e
+"$ducc" -include-pch prelude.h.pch main.c > /dev/null 2> output
+exit_code=$?
+set -e
+if [[ $exit_code -eq 0 ]]; then
+    echo "expected to fail" >&2
+    exit 1
+fi
+diff -u expected output
+
+# the precompiled header is rejected if another version of ducc wrote it
+touch prelude.h
+"$ducc" -x c-header -o prelude.h.pch prelude.h
+version="$("$ducc" --version)"
+version="${version#ducc v}"
+LC_ALL=C sed "s/$version/${version//?/x}/" prelude.h.pch > other.pch
+cat <<'EOF' > expected
+other.pch: precompiled header was built by another version of ducc
+EOF
+set +e
+"$ducc" -include-pch other.pch main.c > /dev/null 2> output
+exit_code=$?
+set -e
+if [[ $exit_code -eq 0 ]]; then
+    echo "expected to fail" >&2
+    exit 1
+fi
+diff -u expected output
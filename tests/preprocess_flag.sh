@@ -120,3 +120,155 @@ int main() {
     bar++;
 }
 EOF
+
+# source read from a pipe
+cat <<'EOF2' > expected
+int x = 42;
+EOF2
+
+printf '#define FOO 42\nint x = FOO;\n' | "$ducc" -E /dev/stdin > output
+diff -u -Z expected output
+
+# source whose size is a multiple of the page size
+cat <<'EOF2' > expected
+int y;
+
+EOF2
+
+page_size="$(getconf PAGESIZE)"
+{ printf 'int y;\n/*'; head -c $((page_size - 12)) /dev/zero | tr '\0' 'x'; printf '*/\n'; } > page.c
+if [[ "$(wc -c < page.c)" -ne "$page_size" ]]; then
+    echo "invalid test input size" >&2
+    exit 1
+fi
+"$ducc" -E page.c > output
+diff -u -Z expected output
+
+# a macro that expands to nothing at the start of a line keeps the rest of the line
+cat <<'EOF' > expected
+ typedef int a;
+ int b;
+EOF
+
+test_cpp <<'EOF'
+#define EMPTY
+EMPTY typedef int a;
+#if 1
+EMPTY EMPTY int b;
+#endif
+EOF
+
+# a redefinition, also after #undef, replaces the earlier definition
+cat <<'EOF' > expected
+2
+3
+EOF
+
+test_cpp <<'EOF'
+#define A 1
+#define A 2
+A
+#undef A
+#define A 3
+A
+EOF
+
+# a macro name left unexpanded inside its own expansion is never expanded later (C23 6.10.5.5 EXAMPLE 3)
+cat <<'EOF' > expected
+a foo
+ff ( 2 * ( ff ( 2 * ( z [ 0])))) % ff ( 2 * ( 0)) + t ( 1);
+EOF
+
+test_cpp <<'EOF'
+#define foo a foo
+#define id(x) x
+id(foo)
+#define x 3
+#define ff(a) ff(x * (a))
+#undef x
+#define x 2
+#define gg ff
+#define z z[0]
+#define t(a) a
+ff(ff(z)) % t(t(gg)(0) + t)(1);
+EOF
+
+# a reused expansion of an object-like macro follows later changes of the macros it uses, and expansions that depend on
+# where they are used are not reused
+cat <<'EOF' > expected
+( 1 + 2) ( 1 + 2)
+( B + 2)
+( 5 + 2)
+[ 1] [ 2] F
+12 12
+13
+P Q P
+EOF
+
+test_cpp <<'EOF'
+#define B 1
+#define A (B + 2)
+A A
+#undef B
+A
+#define B 5
+A
+#define F(x) [x]
+#define G F
+G(1) G (2) G
+#define L __LINE__
+L L
+L
+#define P Q
+#define Q P
+P Q P
+EOF
+
+# --line-markers
+cat <<'EOF' > header.h
+#define VALUE 7
+int h;
+EOF
+
+cat <<'EOF' > main.c
+#include "header.h"
+#define F(x) x
+int a = F(
+  1) + F(2
+  );
+
+
+
+int b;
+
+
+
+
+
+
+
+
+
+
+
+
+int c = VALUE;
+EOF
+
+cat <<'EOF' > expected
+# 2 "./header.h"
+int h;
+# 3 "main.c"
+int a = 1
+ + 2
+;
+
+
+
+int b;
+# 22 "main.c"
+int c = 7;
+EOF
+
+"$ducc" --line-markers -E main.c > output
+diff -u expected output
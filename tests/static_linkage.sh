@@ -13,6 +13,12 @@ static char* f8() { return 0; }
 void** f9() { return 0; }
 static void** f10() { return 0; }
 
+static int v1, *v2;
+int v3, *v4;
+typedef int T;
+static T v5;
+T v6;
+
 int main() { }
 EOF
 
@@ -46,3 +52,11 @@ assert_local f5
 assert_local f6
 assert_local f8
 assert_local f10
+
+assert_global v3
+assert_global v4
+assert_global v6
+
+assert_local v1
+assert_local v2
+assert_local v5
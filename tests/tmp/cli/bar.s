@@ -0,0 +1,23 @@
+.intel_syntax noprefix
+
+.file 1 "foo.c"
+
+.section .note.GNU-stack,"",@progbits
+
+.section .rodata
+
+.data
+
+.text
+
+.globl main
+main:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 1 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+
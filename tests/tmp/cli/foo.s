@@ -0,0 +1,82 @@
+.intel_syntax noprefix
+
+.file 1 "foo.c"
+
+.section .note.GNU-stack,"",@progbits
+
+.section .rodata
+
+.data
+
+.text
+
+.globl f
+f:
+  push rbp
+  mov rbp, rsp
+  push rdi
+  push rsi
+  sub rsp, 24
+  .loc 1 1 0
+  .loc 1 1 0
+  lea rax, -8[rbp]
+  movsxd rax, DWORD PTR [rax]
+  push rax
+  lea rax, -16[rbp]
+  movsxd rax, DWORD PTR [rax]
+  mov rdi, rax
+  pop rax
+  add rax, rdi
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+.globl main
+main:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 2 0
+  .loc 1 2 0
+  mov rax, rsp
+  and rax, 15
+  cmp rax, 0
+  je .Laligned1
+  sub rsp, 8
+  mov rax, 2
+  push rax
+  mov rax, 1
+  push rax
+  pop rdi
+  pop rsi
+  mov rax, 0
+  call f
+  add rsp, 8
+  jmp .Lend1
+.Laligned1:
+  mov rax, 2
+  push rax
+  mov rax, 1
+  push rax
+  pop rdi
+  pop rsi
+  mov rax, 0
+  call f
+.Lend1:
+  add rsp, 0
+  push rax
+  mov rax, 3
+  mov rdi, rax
+  pop rax
+  sub rax, rdi
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+
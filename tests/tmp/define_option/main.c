@@ -0,0 +1,5 @@
+int printf(const char*, ...);
+
+int main() {
+    printf("%d,%d\n", A, B);
+}
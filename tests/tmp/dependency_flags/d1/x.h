@@ -0,0 +1 @@
+#include_next <x.h>
@@ -0,0 +1,3 @@
+#pragma once
+#include "sub/guarded.h"
+#define ENABLED 1
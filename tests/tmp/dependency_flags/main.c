@@ -0,0 +1,2 @@
+#include "header.h"
+int main() { return ENABLED - 1; }
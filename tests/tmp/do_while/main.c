@@ -0,0 +1,19 @@
+int printf();
+
+int foo(int i) {
+    printf("foo %d\n", i);
+    return i;
+}
+
+int main() {
+    int i = 0;
+    do {
+        ++i;
+        if (i % 2 == 0) {
+            continue;
+        }
+        printf("body %d\n", i);
+    } while (foo(i) < 5);
+
+    return 0;
+}
@@ -0,0 +1,3 @@
+struct S { long a, b, c; } arr[] = {
+#embed "data.bin"
+};
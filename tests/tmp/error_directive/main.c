@@ -0,0 +1,5 @@
+#define \
+    A \
+    B
+
+#error "foo"
@@ -0,0 +1,15 @@
+struct FILE;
+typedef struct FILE FILE;
+extern FILE* stdin;
+extern FILE* stdout;
+int fprintf();
+char* fgets();
+void* calloc();
+
+int main() {
+    char* buf = calloc(256, sizeof(char));
+    while (fgets(buf, 256, stdin)) {
+        fprintf(stdout, "%s%s", buf, buf);
+    }
+    return 0;
+}
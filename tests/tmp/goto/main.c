@@ -0,0 +1,20 @@
+int printf(const char*, ...);
+
+int main() {
+    int x = 2;
+    switch (x) {
+    case 1:
+        printf("case 1\n");
+        break;
+    case 2:
+        printf("case 2\n");
+        goto done;
+    case 3:
+        printf("case 3\n");
+        break;
+    }
+    printf("after switch\n");
+done:
+    printf("done\n");
+    return 0;
+}
@@ -0,0 +1,2 @@
+#include "b.h"
+int a() { return 1; }
@@ -0,0 +1 @@
+#include "baz.h"
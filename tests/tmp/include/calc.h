@@ -0,0 +1,7 @@
+#include "math.h"
+
+int calculate(int x) {
+    return multiply(x, 2);
+}
+
+int printf(const char*, ...);
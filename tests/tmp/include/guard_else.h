@@ -0,0 +1,6 @@
+#ifndef GUARD_ELSE_H
+#define GUARD_ELSE_H
+printf("if\n");
+#else
+printf("else\n");
+#endif
@@ -0,0 +1,4 @@
+#ifndef GUARD_TRAILER_H
+#define GUARD_TRAILER_H
+#endif
+printf("trailer\n");
@@ -0,0 +1,6 @@
+#ifndef HEADER_H
+#define HEADER_H
+
+int f() { return 42; }
+
+#endif
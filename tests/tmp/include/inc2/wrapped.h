@@ -0,0 +1 @@
+#define SECOND 2
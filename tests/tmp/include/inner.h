@@ -0,0 +1,2 @@
+#define INNER(x) (x * 10)
+enum { inner = INNER(OUTER) };
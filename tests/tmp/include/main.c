@@ -0,0 +1,16 @@
+#include <stdarg.h>
+#include <stddef.h>
+
+int printf(const char*, ...);
+
+int first(int n, ...) {
+    va_list args;
+    va_start(args, n);
+    int x = va_arg(args, int);
+    va_end(args);
+    return x;
+}
+
+int main() {
+    printf("%d\n", first(1, 42 + (int)offsetof(struct { int a; }, a)));
+}
@@ -0,0 +1,2 @@
+#pragma once
+printf("once\n");
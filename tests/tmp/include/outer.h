@@ -0,0 +1,5 @@
+#define OUTER 4
+#if OUTER > 3
+#include "inner.h"
+enum { outer = inner + 2 };
+#endif
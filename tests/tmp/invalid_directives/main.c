@@ -0,0 +1,5 @@
+#if 0
+#baz
+#endif
+
+int main() {}
@@ -0,0 +1,20 @@
+int printf(const char*, ...);
+#ifdef X
+  "a
+#endif
+#if 1 + 1 == 3 // "b
+  'c
+#else /* " */
+int z = 3;
+#endif
+#ifndef __LINE__
+"d
+#elif 1
+int w;
+#elifdef __LINE__
+"e
+#endif
+
+int main() {
+    printf("z = %d\n", z);
+}
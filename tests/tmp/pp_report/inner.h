@@ -0,0 +1,9 @@
+#ifndef INNER_H
+#define INNER_H
+#define TWICE(x) x x
+#if 0
+skipped
+skipped
+#endif
+int inner;
+#endif
@@ -0,0 +1,4 @@
+#include "outer.h"
+#include "inner.h"
+int a = ONE + ONE;
+int b = TWICE(ONE);
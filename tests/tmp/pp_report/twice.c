@@ -0,0 +1,2 @@
+#include "inner.h"
+#include "sub/../inner.h"
@@ -0,0 +1,5 @@
+#include "prelude.h"
+int main() {
+    struct point p = {SQUARE(3), add(2, 3)};
+    printf("%s %d %d %d\n", GREETING, p.x, p.y, (int)offsetof(struct point, y));
+}
@@ -0,0 +1,14 @@
+#ifndef PRELUDE_H
+#define PRELUDE_H
+#include <stddef.h>
+int printf(const char*, ...);
+#define SQUARE(x) ((x) * (x))
+#define GREETING "hello"
+struct point {
+    int x;
+    int y;
+};
+static int add(int a, int b) {
+    return a + b;
+}
+#endif
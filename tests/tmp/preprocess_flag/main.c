@@ -0,0 +1,22 @@
+#include "header.h"
+#define F(x) x
+int a = F(
+  1) + F(2
+  );
+
+
+
+int b;
+
+
+
+
+
+
+
+
+
+
+
+
+int c = VALUE;
@@ -0,0 +1,21 @@
+int f1() { return 0; }
+int* f2() { return 0; }
+int** f3() { return 0; }
+
+static int f4() { return 0; }
+static int* f5() { return 0; }
+static int** f6() { return 0; }
+
+char* f7() { return 0; }
+static char* f8() { return 0; }
+
+void** f9() { return 0; }
+static void** f10() { return 0; }
+
+static int v1, *v2;
+int v3, *v4;
+typedef int T;
+static T v5;
+T v6;
+
+int main() { }
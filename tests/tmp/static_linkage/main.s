@@ -0,0 +1,183 @@
+.intel_syntax noprefix
+
+.file 1 "main.c"
+
+.section .note.GNU-stack,"",@progbits
+
+.section .rodata
+
+.data
+
+  v1:
+    .zero 4
+  v2:
+    .zero 8
+.globl v3
+  v3:
+    .zero 4
+.globl v4
+  v4:
+    .zero 8
+  v5:
+    .zero 4
+.globl v6
+  v6:
+    .zero 4
+.text
+
+.globl f1
+f1:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 1 0
+  .loc 1 1 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+.globl f2
+f2:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 2 0
+  .loc 1 2 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+.globl f3
+f3:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 3 0
+  .loc 1 3 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+f4:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 5 0
+  .loc 1 5 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+f5:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 6 0
+  .loc 1 6 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+f6:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 7 0
+  .loc 1 7 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+.globl f7
+f7:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 9 0
+  .loc 1 9 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+f8:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 10 0
+  .loc 1 10 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+.globl f9
+f9:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 12 0
+  .loc 1 12 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+f10:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 13 0
+  .loc 1 13 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+  mov rsp, rbp
+  pop rbp
+  ret
+
+.globl main
+main:
+  push rbp
+  mov rbp, rsp
+  sub rsp, 0
+  .loc 1 21 0
+  mov rax, 0
+  mov rsp, rbp
+  pop rbp
+  ret
+
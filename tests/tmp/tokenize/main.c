@@ -0,0 +1,9 @@
+int printf(const char*, ...);
+#define CAT(a, b) a##b
+#define ANSWER 42
+CAT(in, t) main() {
+    CAT(unsig, ned) CAT(ans, wer) = ANS\
+WER;
+    printf("%u\n", an\
+swer);
+}
@@ -0,0 +1 @@
+int printf(const char*, ...);int main() {    printf("Hello World\n");    printf("Line con\tinues\n");    return 0;}
\ No newline at end of file
@@ -0,0 +1,7 @@
+int printf(const char*, ...);
+int main() {
+    printf("Hello World\n");
+    printf("Line con\
+tinues\n");
+    return 0;
+}
@@ -0,0 +1,9 @@
+int long_identifier_name_0123456789 = 0x1234abcd;
+const char* s = "a string literal with \"quotes\" and \\ backslashes";
+/* a block comment that spans
+   more than one line ** */ // a line comment \
+continued
+int spliced_iden\
+tifier_after_a_splice	= 12\
+34;
+char cé = 0;
@@ -99,6 +99,13 @@ test_diff < main_cr.c
 printf 'int printf(const char*, ...);\nint main() {\r\n    printf("Hello World\\n");\r    printf("Line con\\\r\ntinues\\n");\n    return 0;\r\n}\r\n' > main_mixed.c
 test_diff < main_mixed.c
 
+# line numbers after line continuations and mixed new-lines
+cat <<'EOF' > expected
+main.c:5: foo
+EOF
+
+printf '#define A \\\r\n    1\r#define B \\\n    2\r\n#error "foo"\n' | test_compile_error
+
 # keywords
 cat <<'EOF' > expected
 
@@ -114,3 +121,25 @@ test_cpp <<'EOF'
 auto printf();
 auto main() {}
 EOF
+
+# the SWAR and scalar scanning kernels produce the same tokens
+printf 'int long_identifier_name_0123456789 = 0x1234abcd;\nconst char* s = "a string literal with \\"quotes\\" and \\\\ backslashes";\n/* a block comment that spans\n   more than one line ** */ // a line comment \\\ncontinued\nint spliced_iden\\\ntifier_after_a_splice\t\v\f= 12\\\n34;\r\nchar c\xc3\xa9 = 0;\n' > scan.c
+"$ducc" -E scan.c > output_swar
+"$ducc" --scalar-lexer -E scan.c > output_scalar
+diff -u output_scalar output_swar
+
+# identifiers made by '##', -D or a line splice are the same identifiers as those spelled out
+cat <<'EOF' > expected
+42
+EOF
+test_diff <<'EOF'
+int printf(const char*, ...);
+#define CAT(a, b) a##b
+#define ANSWER 42
+CAT(in, t) main() {
+    CAT(unsig, ned) CAT(ans, wer) = ANS\
+WER;
+    printf("%u\n", an\
+swer);
+}
+EOF
@@ -89,6 +89,15 @@ enum E2 {
     E2_H = E2_G,
 };
 
+// More than 1000 members
+#define E4(p) p##0, p##1, p##2, p##3,
+#define E16(p) E4(p##0) E4(p##1) E4(p##2) E4(p##3)
+#define E64(p) E16(p##0) E16(p##1) E16(p##2) E16(p##3)
+#define E256(p) E64(p##0) E64(p##1) E64(p##2) E64(p##3)
+enum E3 {
+    E256(E3_0) E256(E3_1) E256(E3_2) E256(E3_3) E3_LAST,
+};
+
 int main() {
     short a = 42;
     ASSERT_EQ(2, sizeof(a));
@@ -153,4 +162,9 @@ int main() {
     ASSERT_EQ(5, E2_F);
     ASSERT_EQ(6, E2_G);
     ASSERT_EQ(6, E2_H);
+
+    ASSERT_EQ(0, E3_00000);
+    ASSERT_EQ(1001, E3_33221);
+    ASSERT_EQ(1023, E3_33333);
+    ASSERT_EQ(1024, E3_LAST);
 }
@@ -118,4 +118,27 @@ int main() {
     ASSERT_EQ(10, arr[0]);
     ASSERT_EQ(20, arr[1]);
     ASSERT_EQ(30, arr[2]);
+
+    // block scopes
+    int g_a = 1;
+    {
+        ASSERT_EQ(1, g_a);
+        int g_a = 2;
+        ASSERT_EQ(2, g_a);
+        {
+            int g_a = 3;
+            ASSERT_EQ(3, g_a);
+        }
+        ASSERT_EQ(2, g_a);
+        for (int g_a = 4; g_a < 5; ++g_a) {
+            ASSERT_EQ(4, g_a);
+        }
+        ASSERT_EQ(2, g_a);
+    }
+    ASSERT_EQ(1, g_a);
+    {
+        int g_k = 5;
+        ASSERT_EQ(5, g_k);
+    }
+    ASSERT_EQ(999, g_k);
 }